@@ -0,0 +1,120 @@
+// Archive tier: closed records evicted from memory live in an append-only file of fixed-size slots
+// Each slot is a live flag followed by the raw record. Lookups go through a small LRU cache so a
+// record that is looked up again doesn't cost another disk read. Deleting only clears the live flag.
+// Record must be trivially copyable; it is stored as raw bytes. Uses syncFile from CHANGELOG.h.
+
+#include <fstream>
+#include <filesystem>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+template <typename Record>
+class ArchiveTier {
+    static_assert(is_trivially_copyable<Record>::value, "archived records are stored as raw bytes");
+
+private:
+    // On-disk slot layout
+    struct Slot {
+        char live;
+        Record record;
+    };
+
+    fstream file;
+    string filePath;
+    size_t cacheCapacity = 16;
+    list<pair<long long, Record>> lru; // Most recently used first
+    unordered_map<long long, typename list<pair<long long, Record>>::iterator> cached; // Offset -> lru entry
+
+public:
+    // Open (creating if needed) the archive and call visit(offset, record) for every live slot
+    bool open(const string &path, size_t cacheRecords, const function<void(long long, const Record &)> &visit) {
+        cacheCapacity = cacheRecords < 1 ? 1 : cacheRecords;
+        filePath = path;
+        { ofstream create(path, ios::binary | ios::app); }
+        file.open(path, ios::binary | ios::in | ios::out);
+        if (!file) return false;
+
+        Slot slot;
+        long long offset = 0;
+        while (file.read((char *)&slot, sizeof(slot))) {
+            if (slot.live) visit(offset, slot.record);
+            offset += sizeof(slot);
+        }
+        file.clear();
+        // Drop a torn slot left by a crash so new slots stay aligned
+        file.seekp(0, ios::end);
+        long long end = file.tellp();
+        if (end != offset) {
+            file.close();
+            error_code ec;
+            filesystem::resize_file(path, offset, ec);
+            file.open(path, ios::binary | ios::in | ios::out);
+        }
+        return (bool)file;
+    }
+
+    bool isOpen() const { return file.is_open(); }
+
+    // Append a record and hand it to the OS; returns its offset, or -1 on failure.
+    // Call sync before anything else relies on the record being on disk.
+    long long append(const Record &record) {
+        Slot slot;
+        slot.live = 1;
+        slot.record = record;
+        file.seekp(0, ios::end);
+        long long offset = file.tellp();
+        file.write((const char *)&slot, sizeof(slot));
+        file.flush();
+        return file ? offset : -1;
+    }
+
+    // Make every appended record survive a power cut; false if the disk didn't confirm it
+    bool sync() {
+        file.flush();
+        return file && syncFile(filePath);
+    }
+
+    // Read a record without touching the cache (for scans that would only flush it)
+    Record readUncached(long long offset) {
+        Slot slot;
+        file.seekg(offset);
+        file.read((char *)&slot, sizeof(slot));
+        file.clear();
+        return slot.record;
+    }
+
+    // Read a record through the LRU cache
+    Record read(long long offset) {
+        auto hit = cached.find(offset);
+        if (hit != cached.end()) {
+            lru.splice(lru.begin(), lru, hit->second);
+            return hit->second->second;
+        }
+        Record record = readUncached(offset);
+        lru.push_front({ offset, record });
+        cached[offset] = lru.begin();
+        if (lru.size() > cacheCapacity) {
+            cached.erase(lru.back().first);
+            lru.pop_back();
+        }
+        return record;
+    }
+
+    // Mark a slot as deleted
+    void remove(long long offset) {
+        auto hit = cached.find(offset);
+        if (hit != cached.end()) {
+            lru.erase(hit->second);
+            cached.erase(hit);
+        }
+        char dead = 0;
+        file.seekp(offset);
+        file.write(&dead, 1);
+        file.flush();
+    }
+
+    size_t cacheSize() const { return lru.size(); }
+};
@@ -0,0 +1,285 @@
+// Change-data-capture log: every add, update and delete becomes a sequenced binary event
+// Events are appended to segment files named <prefix><first sequence>.log, and a new segment is
+// started once the current one passes the size limit. Consumers read with a ChangeCursor from a
+// saved sequence number, so catching up costs as much as the changes made, not the dataset size.
+// Old segments are removed once everything that replays from the log has moved past them.
+// Record must be trivially copyable; it is stored as raw bytes.
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#ifdef _WIN32
+#include <io.h>     // _open, _commit
+#include <fcntl.h>
+#else
+#include <fcntl.h>  // open, for syncing a file by name
+#include <unistd.h> // fsync
+#endif
+
+enum ChangeType { CHANGE_ADD = 1, CHANGE_UPDATE = 2, CHANGE_DELETE = 3 };
+
+// One change as seen by a consumer; for deletes, record holds the removed record
+template <typename Record>
+struct ChangeEvent {
+    unsigned long long seq;
+    ChangeType type;
+    int id;
+    Record record;
+};
+
+// On-disk header in front of every record
+struct ChangeHeader {
+    uint32_t magic;
+    uint32_t type;
+    uint64_t seq;
+    int32_t id;
+    uint32_t size;
+};
+
+const uint32_t CHANGE_MAGIC = 0x52434443; // "CDCR"
+
+// Make a file's written data survive a power cut; false if the disk didn't confirm it.
+// Works on the file by name, so streams that don't expose a descriptor can use it after flushing.
+inline bool syncFile(const string &path) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    bool ok = fd >= 0 && _commit(fd) == 0;
+    if (fd >= 0) _close(fd);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    bool ok = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+#endif
+    return ok;
+}
+
+// Segment files for a prefix, sorted by the first sequence number they hold
+inline vector<pair<unsigned long long, string>> listChangeSegments(const string &prefix) {
+    vector<pair<unsigned long long, string>> segments;
+    filesystem::path base(prefix);
+    filesystem::path dir = base.parent_path().empty() ? filesystem::path(".") : base.parent_path();
+    string stem = base.filename().string();
+    error_code ec;
+    for (const auto &entry : filesystem::directory_iterator(dir, ec)) {
+        string name = entry.path().filename().string();
+        if (name.size() <= stem.size() + 4 || name.compare(0, stem.size(), stem) != 0
+            || name.compare(name.size() - 4, 4, ".log") != 0) continue;
+        string digits = name.substr(stem.size(), name.size() - stem.size() - 4);
+        if (digits.find_first_not_of("0123456789") != string::npos) continue;
+        segments.push_back({ stoull(digits), entry.path().string() });
+    }
+    sort(segments.begin(), segments.end());
+    return segments;
+}
+
+// Read one event; returns false (and leaves the stream where it was) if it isn't complete yet
+template <typename Record>
+bool readChangeEvent(ifstream &in, ChangeEvent<Record> &event) {
+    streampos start = in.tellg();
+    ChangeHeader header;
+    if (in.read((char *)&header, sizeof(header)) && header.magic == CHANGE_MAGIC && header.size == sizeof(Record)
+        && in.read((char *)&event.record, sizeof(Record))) {
+        event.seq = header.seq;
+        event.type = (ChangeType)header.type;
+        event.id = header.id;
+        return true;
+    }
+    in.clear();
+    in.seekg(start);
+    return false;
+}
+
+// Sequence number of the newest complete event under a prefix (0 if there are none)
+template <typename Record>
+unsigned long long lastChangeSequence(const string &prefix) {
+    vector<pair<unsigned long long, string>> segments = listChangeSegments(prefix);
+    if (segments.empty()) return 0;
+    unsigned long long last = segments.back().first - 1;
+    ifstream in(segments.back().second, ios::binary);
+    ChangeEvent<Record> event;
+    while (readChangeEvent(in, event)) last = event.seq;
+    return last;
+}
+
+// First sequence number still on disk under a prefix (0 if there are no segments)
+inline unsigned long long firstChangeSequence(const string &prefix) {
+    vector<pair<unsigned long long, string>> segments = listChangeSegments(prefix);
+    return segments.empty() ? 0 : segments.front().first;
+}
+
+// Appends events; used only by the thread that applies mutations.
+// Events are numbered as they are appended but only reach the file on flush. If a write fails
+// (a full disk, say), the segment is cut back to its last good size and the events stay pending,
+// so the next flush writes them again in order and the file never skips a sequence number.
+template <typename Record>
+class ChangeLog {
+    static_assert(is_trivially_copyable<Record>::value, "change log records are stored as raw bytes");
+
+private:
+    string prefix;
+    size_t maxSegmentBytes = 0;
+    ofstream out;
+    string segmentPath;   // Segment being appended to
+    size_t segmentBytes = 0; // Bytes known to be written to it
+    string pending;       // Appended events not written yet
+    unsigned long long lastSeq = 0;
+
+    // Write pending events to the current segment; on failure undo the partial write
+    bool writePending() {
+        if (pending.empty()) return true;
+        if (!out.is_open() || !out) {
+            out.close();
+            out.clear();
+            error_code ec;
+            filesystem::resize_file(segmentPath, segmentBytes, ec);
+            out.open(segmentPath, ios::binary | ios::app);
+        }
+        out.write(pending.data(), pending.size());
+        out.flush();
+        if (!out) return false;
+        segmentBytes += pending.size();
+        pending.clear();
+        return true;
+    }
+
+    // Start a new segment whose first event will be lastSeq + 1 (nothing may be pending).
+    // The finished segment is synced first, since later durable flushes only sync the new one;
+    // if that fails the current segment is kept and the next rotation tries again.
+    void rotate() {
+        if (out.is_open()) {
+            if (!syncFile(segmentPath)) return;
+            out.close();
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%020llu.log", lastSeq + 1);
+        segmentPath = prefix + name;
+        out.clear();
+        out.open(segmentPath, ios::binary | ios::app);
+        segmentBytes = 0;
+    }
+
+public:
+    // Find the last sequence number and reopen the newest segment, dropping any torn tail
+    void open(const string &filePrefix, size_t segmentLimit) {
+        prefix = filePrefix;
+        maxSegmentBytes = segmentLimit;
+        vector<pair<unsigned long long, string>> segments = listChangeSegments(prefix);
+        if (segments.empty()) {
+            rotate();
+            return;
+        }
+        const string &path = segments.back().second;
+        lastSeq = segments.back().first - 1;
+        size_t validBytes = 0;
+        {
+            ifstream in(path, ios::binary);
+            ChangeEvent<Record> event;
+            while (readChangeEvent(in, event)) {
+                lastSeq = event.seq;
+                validBytes += sizeof(ChangeHeader) + sizeof(Record);
+            }
+        }
+        error_code ec;
+        filesystem::resize_file(path, validBytes, ec);
+        segmentPath = path;
+        out.open(path, ios::binary | ios::app);
+        segmentBytes = validBytes;
+    }
+
+    // Append one event and return its sequence number; it reaches the file on the next flush
+    unsigned long long append(ChangeType type, int id, const Record &record) {
+        if (segmentBytes + pending.size() >= maxSegmentBytes && writePending()) rotate();
+        ChangeHeader header = { CHANGE_MAGIC, (uint32_t)type, ++lastSeq, id, (uint32_t)sizeof(Record) };
+        pending.append((const char *)&header, sizeof(header));
+        pending.append((const char *)&record, sizeof(Record));
+        return lastSeq;
+    }
+
+    // Sequence number of the newest appended event
+    unsigned long long lastSequence() const { return lastSeq; }
+
+    // Push appended events to the OS so consumers can see them. With durable set they are also
+    // synced to the disk, which must happen before anything that records lastSequence() is saved.
+    // False if they couldn't be written; they are kept and written by a later flush.
+    bool flush(bool durable = false) {
+        if (!writePending()) return false;
+        return !durable || syncFile(segmentPath);
+    }
+
+    // Remove whole segments whose events are all at or below seq, keeping at least the newest keep
+    // segments for consumers that are a little behind. Readers past a removed segment start at the
+    // oldest one left (see ChangeCursor).
+    void removeSegmentsThrough(unsigned long long seq, size_t keep) {
+        vector<pair<unsigned long long, string>> segments = listChangeSegments(prefix);
+        for (size_t i = 0; i + keep < segments.size() && i + 1 < segments.size(); ++i) {
+            if (segments[i + 1].first - 1 > seq || segments[i].second == segmentPath) break;
+            remove(segments[i].second.c_str());
+        }
+    }
+};
+
+// Reads events in order starting from a sequence number
+template <typename Record>
+class ChangeCursor {
+private:
+    string prefix;
+    unsigned long long nextSeq;
+    ifstream in;
+    unsigned long long segmentFirst = 0;
+
+    // Open the segment holding nextSeq (or the next one after it) and skip to nextSeq
+    bool openSegment() {
+        vector<pair<unsigned long long, string>> segments = listChangeSegments(prefix);
+        size_t chosen = segments.size();
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (segments[i].first <= nextSeq) chosen = i;
+        }
+        if (segments.empty()) return false;
+        if (chosen == segments.size()) chosen = 0; // Older segments were removed; start at the oldest kept
+        if (in.is_open()) in.close();
+        in.clear();
+        in.open(segments[chosen].second, ios::binary);
+        segmentFirst = segments[chosen].first;
+        ChangeEvent<Record> event;
+        streampos before = in.tellg();
+        while (readChangeEvent(in, event)) {
+            if (event.seq >= nextSeq) {
+                in.seekg(before);
+                break;
+            }
+            before = in.tellg();
+        }
+        return true;
+    }
+
+public:
+    ChangeCursor(const string &filePrefix, unsigned long long fromSeq) : prefix(filePrefix), nextSeq(fromSeq < 1 ? 1 : fromSeq) {}
+
+    // Sequence number the next read starts at; save it to resume later
+    unsigned long long position() const { return nextSeq; }
+
+    // Read up to max events; returns how many were added to out (0 when caught up)
+    size_t read(vector<ChangeEvent<Record>> &out, size_t max) {
+        size_t count = 0;
+        if (!in.is_open() && !openSegment()) return 0;
+        while (count < max) {
+            ChangeEvent<Record> event;
+            if (readChangeEvent(in, event)) {
+                out.push_back(event);
+                nextSeq = event.seq + 1;
+                ++count;
+                continue;
+            }
+            // End of this segment: move on only if a later one has started
+            unsigned long long current = segmentFirst;
+            vector<pair<unsigned long long, string>> segments = listChangeSegments(prefix);
+            if (segments.empty() || segments.back().first <= current || !openSegment() || segmentFirst == current) break;
+        }
+        return count;
+    }
+};
@@ -1,10 +1,16 @@
 #include <iostream>
 #include <fstream>
-#include <queue>
+#include <deque>
+#include <vector>
+#include <unordered_map>
 #include <string>
 #include <cctype>
+#include <cmath>
 using namespace std;
 
+#include "SERIAL.h"
+#include "VALIDATE.h"
+
 class Rental {
 public:
     string renterName;
@@ -12,20 +18,14 @@ public:
     string phoneVariant;
     string startDate;
     string endDate;
-    double totalAmount;
+    long long totalCentavos; // Exact amount; 1 peso = 100 centavos
 
     bool isAlphabetic(const string& str) {
-        for (char c : str) {
-            if (!isalpha(c) && c != ' ') return false;
-        }
-        return true;
+        return validName(str);
     }
 
     bool isNumeric(const string& str) {
-        for (char c : str) {
-            if (!isdigit(c) && c != '.') return false;
-        }
-        return true;
+        return validAmount(str);
     }
 
     void input() {
@@ -68,11 +68,10 @@ public:
         while (true) {
             cout << "Enter Total Amount: ";
             getline(cin, amountInput);
-            if (isNumeric(amountInput) && !amountInput.empty()) {
-                totalAmount = atof(amountInput.c_str());
+            if (isNumeric(amountInput) && parseCentavos(amountInput, totalCentavos)) {
                 break;
             } else {
-                cout << "Invalid amount. Please enter a valid number.\n";
+                cout << "Invalid amount. Please enter a number with at most two decimals.\n";
             }
         }
     }
@@ -84,16 +83,16 @@ public:
         cout << "Phone Variant : " << phoneVariant << endl;
         cout << "Start Date    : " << startDate << endl;
         cout << "End Date      : " << endDate << endl;
-        cout << "Total Amount  : PHP " << totalAmount << endl;
+        cout << "Total Amount  : PHP " << formatCentavos(totalCentavos) << endl;
     }
 
-    void writeToFile(ofstream &out) const {
-        out << renterName << endl;
-        out << phoneModel << endl;
-        out << phoneVariant << endl;
-        out << startDate << endl;
-        out << endDate << endl;
-        out << totalAmount << endl;
+    void writeToFile(RecordWriter &out) const {
+        out.text(renterName); out.put('\n');
+        out.text(phoneModel); out.put('\n');
+        out.text(phoneVariant); out.put('\n');
+        out.text(startDate); out.put('\n');
+        out.text(endDate); out.put('\n');
+        out.centavos(totalCentavos); out.put('\n');
     }
 
     bool readFromFile(ifstream &in) {
@@ -104,36 +103,77 @@ public:
         if (!getline(in, endDate)) return false;
         string amountStr;
         if (!getline(in, amountStr)) return false;
-        totalAmount = atof(amountStr.c_str());
+        if (!parseCentavos(amountStr, totalCentavos)) {
+            // Older files stored a double at 6 significant digits, e.g. 1.23457e+06
+            totalCentavos = llround(atof(amountStr.c_str()) * 100);
+        }
         return true;
     }
 };
 
-queue<Rental> rentals;
+deque<Rental> rentals;
+RecordWriter saveBuffer; // Reused by every save
+
+// Everything one renter has rented, kept current as rentals are added and deleted
+struct RenterHistory {
+    vector<size_t> positions;   // Indexes into rentals, oldest first
+    long long lifetimeCentavos = 0;
+};
+unordered_map<string, RenterHistory> renters; // Normalized renter name -> history
+
+// Lower-case a name and collapse runs of spaces, so "ana  CRUZ" and "Ana Cruz" are the same renter
+string normalizeName(const string &name) {
+    string key;
+    for (char c : name) {
+        if (c == ' ') {
+            if (!key.empty() && key.back() != ' ') key += ' ';
+        } else {
+            key += (char)tolower((unsigned char)c);
+        }
+    }
+    if (!key.empty() && key.back() == ' ') key.pop_back();
+    return key;
+}
+
+// Add the rental at this position to its renter's history
+void indexRental(size_t pos) {
+    RenterHistory &history = renters[normalizeName(rentals[pos].renterName)];
+    history.positions.push_back(pos);
+    history.lifetimeCentavos += rentals[pos].totalCentavos;
+}
+
+// Rebuild every renter's history after positions have shifted
+void rebuildIndex() {
+    renters.clear();
+    for (size_t i = 0; i < rentals.size(); ++i) indexRental(i);
+}
 
 void saveToFile() {
-    ofstream out("rentals.txt");
-    queue<Rental> temp = rentals;
-    while (!temp.empty()) {
-        temp.front().writeToFile(out);
-        temp.pop();
+    if (!saveBuffer.open("rentals.txt")) {
+        cout << "Could not open rentals.txt for saving.\n";
+        return;
+    }
+    for (const Rental &r : rentals) {
+        r.writeToFile(saveBuffer);
     }
-    out.close();
+    if (!saveBuffer.close()) cout << "Could not save rentals.txt.\n";
 }
 
 void loadFromFile() {
     ifstream in("rentals.txt");
     Rental r;
     while (r.readFromFile(in)) {
-        rentals.push(r);
+        rentals.push_back(r);
     }
     in.close();
+    rebuildIndex();
 }
 
 void addRental() {
     Rental r;
     r.input();
-    rentals.push(r);
+    rentals.push_back(r);
+    indexRental(rentals.size() - 1);
     saveToFile();
     cout << "Rental added successfully!\n";
 }
@@ -143,10 +183,8 @@ void displayRentals() {
         cout << "\nNo rentals to display.\n";
         return;
     }
-    queue<Rental> temp = rentals;
-    while (!temp.empty()) {
-        temp.front().display();
-        temp.pop();
+    for (const Rental &r : rentals) {
+        r.display();
     }
 }
 
@@ -154,18 +192,19 @@ void deleteRental() {
     string name;
     cout << "\nEnter Renter Name to delete: ";
     getline(cin, name);
-    queue<Rental> temp;
+    deque<Rental> temp;
     bool found = false;
 
     while (!rentals.empty()) {
         if (rentals.front().renterName != name) {
-            temp.push(rentals.front());
+            temp.push_back(rentals.front());
         } else {
             found = true;
         }
-        rentals.pop();
+        rentals.pop_front();
     }
     rentals = temp;
+    if (found) rebuildIndex(); // Deleting already copies every rental, so this adds no extra pass
     saveToFile();
 
     if (found)
@@ -174,26 +213,24 @@ void deleteRental() {
         cout << "Rental not found.\n";
 }
 
+// Looks the renter up in the history index, so the cost is their own rentals, not the whole list
 void searchRental() {
     string name;
     cout << "\nEnter Renter Name to search: ";
     getline(cin, name);
-    bool found = false;
 
-    queue<Rental> temp = rentals;
-    while (!temp.empty()) {
-        if (temp.front().renterName == name) {
-            cout << "\nRental found:";
-            temp.front().display();
-            found = true;
-            break;
-        }
-        temp.pop();
-    }
-
-    if (!found) {
+    auto it = renters.find(normalizeName(name));
+    if (it == renters.end()) {
         cout << "Rental not found.\n";
+        return;
+    }
+    const RenterHistory &history = it->second;
+    for (size_t pos : history.positions) {
+        cout << "\nRental found:";
+        rentals[pos].display();
     }
+    cout << "\n" << name << " has " << history.positions.size() << " rental(s), lifetime spend PHP "
+         << formatCentavos(history.lifetimeCentavos) << endl;
 }
 
 void bubbleSortAndDisplay() {
@@ -204,10 +241,8 @@ void bubbleSortAndDisplay() {
     }
 
     Rental* arr = new Rental[size];
-    queue<Rental> temp = rentals;
     for (int i = 0; i < size; ++i) {
-        arr[i] = temp.front();
-        temp.pop();
+        arr[i] = rentals[i];
     }
 
     for (int i = 0; i < size - 1; ++i) {
@@ -1,11 +1,29 @@
 #include <iostream> // For input/output operations
 #include <fstream>  // For file handling
-#include <queue>    // For using the queue data structure
+#include <map>      // For the record store and its indexes
+#include <vector>   // For candidate lists in queries
+#include <algorithm> // For sorting query results
 #include <cstring>  // For C-style string functions like strcpy, strcmp, etc.
 #include <limits>   // For numeric limits used in input handling
+#include <sstream>  // For discarding output during load tests
+#include <unordered_map> // For matching archived records while loading, and the renter index
+#include <chrono>   // For timing the save benchmark
 
 using namespace std; // Use the standard namespace
 
+#include "QUERY.h"  // Query language parser
+#include "SCHEDULER.h" // Due-date min-heap
+#include "WRITER.h"    // Background persistence thread
+#include "LOADTEST.h"  // Command replay and latency report
+#include "CHANGELOG.h" // Change-data-capture feed
+#include "ARCHIVE.h"   // On-disk tier for closed rentals
+#include "SORT.h"      // Radix sort engine for exports
+#include "LSM.h"       // On-disk renter name store
+#include "SERIAL.h"    // Buffered serializer for saves
+#include "VALIDATE.h"  // Name, amount and date validation
+#include "SNAPSHOT.h"  // Checksummed, atomically replaced data file
+#include "REPLICATION.h" // Streaming the change log to follower processes
+
 // Define a struct to hold the rental information
 struct Rental {
     char renterName[100];   // Character array for renter's name
@@ -17,15 +35,50 @@ struct Rental {
     int totalAmount;        // Total rental cost
 };
 
+// Everything a renter has rented, with running totals kept current by add and delete
+struct RenterProfile {
+    string displayName;     // Name as first entered
+    vector<int> ids;        // Record IDs in insertion order
+    long long lifetimeSpend = 0; // Sum of totalAmount over ids
+};
+
+// Sort keys of a batch of records being exported, one column per key
+struct ExportBatch {
+    vector<int> ids;                  // Record IDs, in ID order
+    vector<string> lines;             // Formatted records (only kept when spilling runs to disk)
+    vector<vector<string>> text;      // Text keys, per key column
+    vector<vector<uint32_t>> numbers; // Numeric keys, order-preserving unsigned, per key column
+};
+
 class RentalServiceSystem {
 private:
-    queue<Rental> rentals; // Queue to store all rental records
+    map<int, Rental> rentals;      // Resident rental records keyed by record ID, in insertion order
+    map<int, long long> archived;  // Archived record IDs -> slot offset in the archive file
+    ArchiveTier<Rental> archive;   // Closed rentals evicted to disk when over the memory budget
+    size_t memoryBudget = 0;       // Bytes of records and indexes allowed; 0 means no limit
+    bool budgetWarned = false;     // Already said the budget can't be met
+    DueScheduler residentByEnd;    // Resident record IDs by end date, to find eviction candidates
+    int nextId = 0;                // ID given to the next stored record
+    multimap<string, int> byName;  // Renter name -> record IDs
+    unordered_map<string, RenterProfile> renters; // Normalized renter name -> history and totals
+    multimap<int, int> byStart;    // Start date (epoch day) -> record IDs
+    ReturnSchedule dueDates;       // Record IDs ordered by end date, upcoming and overdue apart
+    LsmStore nameStore;            // Renter name -> records on disk, kept current by the writer thread
+    BackgroundWriter<Rental> writer; // Saves changes to the data file off the menu thread
+    string dataFile = "rentals.txt"; // File the records are loaded from and saved to
+    ChangeLog<Rental> changeLog;     // Sequenced add/update/delete events (written by the writer thread)
+    RecordWriter saveBuffer;         // Reused by every save (writer thread only)
+    unsigned long long snapshotGeneration = 0; // Newest snapshot of the data file (writer thread once started)
+    string replicationHost = "127.0.0.1"; // Address followers connect to
+    int replicationPort = 0;         // Port followers connect to; 0 when not leading
+    ReplicationLeader<Rental> replicationLeader; // Streams the change log to followers
 
     void getName(char name[]); // Function to get renter name
     void getPhoneModel(char model[], char variant[]); // Function to select phone model and variant
     void getDate(char date[], const string &prompt); // Function to input date with format validation
     int calculateDays(const char start[], const char end[]); // Function to calculate number of days between two dates
-    void saveToFile(); // Save queue of rentals to a file
+    bool saveToFile(const map<int, Rental> &records, string &error); // Save records to a file (runs on the writer thread)
+    void reportWriteErrors(); // Show any error the background writer ran into
     void loadFromFile(); // Load rental records from a file
     void addRental(); // Add a new rental record
     void displayAll(); // Display all rentals
@@ -34,9 +87,68 @@ private:
     void displayGroupInfo(); // Display information about the project group
     void showMenu(); // Main menu interface
     void searchRental(); // Search for a rental by renter name
+    void printRental(const Rental &r); // Print one record on a single line
+    int storeRental(const Rental &r); // Add a record to the store and its indexes
+    void indexRental(int id, const Rental &r); // Add a record to every index
+    void unindexRental(int id, const Rental &r); // Remove a record from every index
+    string normalizeName(const string &name); // Case- and spacing-insensitive renter key
+    void removeRental(int id); // Remove a record from the store and its indexes
+    const char *fieldText(const Rental &r, QueryField f); // Text value of a record field
+    int fieldNumber(const Rental &r, QueryField f); // Numeric value of a record field
+    bool matches(const Rental &r, const Predicate &p); // Check one predicate against a record
+    vector<int> planQuery(const Query &q, string &path); // Choose an access path and collect candidate IDs
+    void executeQuery(const string &text); // Parse, plan, run and print a query
+    void queryRentals(); // Menu option for running a query
+    void showDueToday(); // List rentals whose end date is today
+    void showOverdue(); // List rentals whose end date has passed
+    void showNextReturns(); // List the next N rentals due back
+    bool isValidName(const string &name); // Letters and spaces only, not empty
+    bool isValidVariant(const string &model, const string &variant); // Variant offered for that model
+    bool isValidDate(const string &date); // MM/DD/YYYY format
+    void startWriter(); // Start background saving of the loaded records
+    void addRecord(const Rental &r); // Store a confirmed rental and queue it for saving
+    bool deleteByName(const string &name); // Delete the oldest rental with this renter name
+    void searchByName(const string &name); // Print the first rental with this renter name
+    void findByNameOrModel(const string &term); // Print every rental matching a name or model
+    void listNextReturns(int n); // Print the next n rentals due back
+    void showProfile(const string &name); // Print a renter's full history and lifetime spend
+    void customerProfile(); // Menu option for a customer profile
+    string formatLine(const Rental &r); // Record in the rentals.txt line format
+    void addToBatch(ExportBatch &batch, const vector<QueryField> &keys, int id, const Rental &r); // Append a record's keys
+    vector<int> sortBatch(ExportBatch &batch, const vector<QueryField> &keys, int threads); // Sorted permutation of a batch
+    string runKey(const ExportBatch &batch, const vector<QueryField> &keys, size_t row); // Byte-comparable key for run merging
+    bool exportSorted(const string &path, const string &keySpec); // Write all records sorted by the given keys
+    bool executeCommand(const string &line); // Run one protocol command line
+    string changeLogPrefix(); // File name prefix of the change log segments
+    Rental getRental(int id); // Fetch a record from memory or the archive
+    void forEachRecord(const function<void(int, const Rental &)> &visit); // Visit every record in ID order
+    size_t recordCount(); // Resident plus archived records
+    void loadArchive(unordered_map<size_t, pair<long long, int>> &archivedLines); // Index archived records without loading them
+    void enforceMemoryBudget(); // Evict closed rentals until records and indexes fit the budget
+    size_t memoryInUse(size_t evicting = 0); // Estimated bytes held for records, indexes and the archive cache
+    bool parseLine(const string &line, Rental &r); // Record from a rentals.txt line
+    size_t storeBatch(vector<Rental> &batch); // Validate and store loaded records; returns how many were invalid
+    string nameStoreKey(const Rental &r); // Name store key: normalized name, then the whole record
+    string nameStoreDir(); // Directory holding the name store segments
+    bool syncNameStore(bool readOnly); // Open the name store and catch it up with the change log
+    void lookupByName(const string &name); // Print a renter's rentals from the name store
+    bool stopBackground(); // Stop the writer, name store and replication threads; false if changes were lost
+    unsigned long long replicationSnapshot(vector<Rental> &records); // Records in the data file and the change seq they include
+    void printReplicationStats(const ReplicationStats &stats, size_t records); // Follower lag and throughput report
 
 public:
-    void run(); // Public function to start the program
+    int run(); // Public function to start the program; returns the exit status
+    void runQuery(const string &text); // Load records and run one query without the menu
+    int runScript(const string &path); // Run protocol commands from a file ("-" for stdin)
+    bool runLoadTest(int count, double rate, const string &path); // Replay a workload and report ops/s and latency
+    void runChangeFeed(const string &offsetFile, int batchSize); // Print changes since the saved offset and advance it
+    void setMemoryBudget(size_t bytes); // Limit memory used by records and their indexes (0 = unlimited)
+    bool runExport(const string &path, const string &keySpec); // Load records and write a sorted export
+    void runLookup(const string &name); // Look a renter up in the name store without loading every record
+    void runSaveBenchmark(int count); // Time saving synthetic records with iostreams and with RecordWriter
+    int runSelfTest(); // Check the sort, name store and compression routines on seeded data; returns the exit status
+    bool setReplicationAddress(const string &address); // Lead replication: accept followers on [host:]port
+    int runFollower(const string &leader); // Replicate from host:port and serve read-only commands from stdin
 };
 
 // Function to get renter name
@@ -45,14 +157,7 @@ void RentalServiceSystem::getName(char name[]) {
     while (true) {
         cout << "Enter Renter Name (letters and spaces only): ";
         getline(cin, tempName);
-        bool valid = !tempName.empty();
-        for (char c : tempName) {
-            if (!isalpha(c) && c != ' ') {
-                valid = false;
-                break;
-            }
-        }
-        if (valid) {
+        if (isValidName(tempName)) {
             strncpy(name, tempName.c_str(), sizeof(Rental::renterName) - 1);
             name[sizeof(Rental::renterName) - 1] = '\0';
             break;
@@ -74,7 +179,7 @@ void RentalServiceSystem::getPhoneModel(char model[], char variant[]) {
             while (true) {
                 cout << "Select Variant (base/pro/pro max): ";
                 getline(cin, tempVariant);
-                if (tempVariant == "base" || tempVariant == "pro" || tempVariant == "pro max") {
+                if (isValidVariant(tempModel, tempVariant)) {
                     break;
                 }
                 cout << "Invalid variant!\n";
@@ -85,7 +190,7 @@ void RentalServiceSystem::getPhoneModel(char model[], char variant[]) {
             while (true) {
                 cout << "Select Variant (base/plus/ultra): ";
                 getline(cin, tempVariant);
-                if (tempVariant == "base" || tempVariant == "plus" || tempVariant == "ultra") {
+                if (isValidVariant(tempModel, tempVariant)) {
                     break;
                 }
                 cout << "Invalid variant!\n";
@@ -107,7 +212,7 @@ void RentalServiceSystem::getDate(char date[], const string &prompt) {
     while (true) {
         cout << prompt;
         getline(cin, tempDate);
-        if (tempDate.length() == 10 && tempDate[2] == '/' && tempDate[5] == '/') {
+        if (isValidDate(tempDate)) {
             strncpy(date, tempDate.c_str(), sizeof(Rental::startDate) - 1);
             date[sizeof(Rental::startDate) - 1] = '\0';
             break;
@@ -116,6 +221,23 @@ void RentalServiceSystem::getDate(char date[], const string &prompt) {
     }
 }
 
+// Check that a name has only letters and spaces
+bool RentalServiceSystem::isValidName(const string &name) {
+    return validName(name);
+}
+
+// Check that a variant is offered for the given phone model
+bool RentalServiceSystem::isValidVariant(const string &model, const string &variant) {
+    if (model == "iPhone 16") return variant == "base" || variant == "pro" || variant == "pro max";
+    if (model == "Samsung Galaxy S25") return variant == "base" || variant == "plus" || variant == "ultra";
+    return false;
+}
+
+// Check the MM/DD/YYYY date format and that the day exists
+bool RentalServiceSystem::isValidDate(const string &date) {
+    return validDate(date);
+}
+
 // Function to calculate rental days
 int RentalServiceSystem::calculateDays(const char start[], const char end[]) {
     int sm, sd, sy, em, ed, ey;
@@ -125,43 +247,292 @@ int RentalServiceSystem::calculateDays(const char start[], const char end[]) {
     return days < 1 ? 1 : days;
 }
 
-// Save rentals to file
-void RentalServiceSystem::saveToFile() {
-    ofstream file("rentals.txt");
-    queue<Rental> temp = rentals;
-    while (!temp.empty()) {
-        Rental r = temp.front();
-        temp.pop();
-        file << r.renterName << "|" << r.phoneModel << "|" << r.modelVariant << "|"
-             << r.startDate << "|" << r.endDate << "|" << r.days << "|" << r.totalAmount << "\n";
+// Save rentals to file as a new snapshot: written to <file>.tmp with a checksum trailer, synced,
+// then renamed into place, so a crash mid-save never leaves a half-written data file.
+// Called by the background writer with its own copy of the records, so apart from saveBuffer and
+// snapshotGeneration (which only this thread uses) it must not touch class state. The menu keeps
+// changing the live records meanwhile; those changes queue up for the next snapshot.
+// Amounts are whole pesos in this program, so the record lines stay as they were.
+bool RentalServiceSystem::saveToFile(const map<int, Rental> &records, string &error) {
+    if (!saveBuffer.open(dataFile + ".tmp")) {
+        error = "could not open " + dataFile + ".tmp";
+        return false;
+    }
+    for (const auto &entry : records) {
+        const Rental &r = entry.second;
+        saveBuffer.text(r.renterName); saveBuffer.put('|');
+        saveBuffer.text(r.phoneModel); saveBuffer.put('|');
+        saveBuffer.text(r.modelVariant); saveBuffer.put('|');
+        saveBuffer.text(r.startDate); saveBuffer.put('|');
+        saveBuffer.text(r.endDate); saveBuffer.put('|');
+        saveBuffer.number(r.days); saveBuffer.put('|');
+        saveBuffer.number(r.totalAmount); saveBuffer.put('\n');
+    }
+    saveBuffer.text(snapshotTrailer(snapshotGeneration + 1, records.size(), saveBuffer.checksum(), changeLog.lastSequence()));
+    if (!saveBuffer.close(true)) {
+        error = "could not write " + dataFile + ".tmp";
+        return false;
+    }
+    if (!commitSnapshot(dataFile, error)) return false;
+    ++snapshotGeneration;
+    return true;
+}
+
+// Show any error the background writer ran into since the last check
+void RentalServiceSystem::reportWriteErrors() {
+    string error = writer.takeError();
+    if (!error.empty()) {
+        cout << "Warning: saving failed (" << error << "). Changes are kept in memory and the save will be retried.\n";
     }
-    cout << "Records saved successfully!\n";
+    error = nameStore.takeError();
+    if (!error.empty()) cout << "Warning: " << error << ". LOOKUP still works and the store will try again.\n";
 }
 
 // Load rentals from file
 void RentalServiceSystem::loadFromFile() {
-    ifstream file("rentals.txt");
+    unordered_map<size_t, pair<long long, int>> archivedLines; // Line hash -> (offset of one copy, copies)
+    loadArchive(archivedLines);
+
+    // Put the newest intact snapshot in place first, in case the last save was interrupted
+    string note;
+    snapshotGeneration = recoverSnapshot(dataFile, note);
+    if (!note.empty()) cout << "Note: " << note << ".\n";
+
+    ifstream file(dataFile);
     if (!file) return;
     string line;
+    vector<Rental> batch;
+    size_t invalid = 0;
     while (getline(file, line)) {
+        // A crash between archiving a record and rewriting the data file leaves it in both.
+        // Only hashes are kept, so a match is confirmed against the archived record itself.
+        auto copy = archivedLines.find(hash<string>()(line));
+        if (copy != archivedLines.end() && copy->second.second > 0
+            && formatLine(archive.readUncached(copy->second.first)) == line) {
+            --copy->second.second;
+            continue;
+        }
         Rental r;
-        size_t pos = 0;
-        for (int i = 0; i < 6; ++i) {
-            size_t next = line.find('|', pos);
-            string val = line.substr(pos, next - pos);
-            switch (i) {
-                case 0: strncpy(r.renterName, val.c_str(), sizeof(r.renterName) - 1); r.renterName[sizeof(r.renterName) - 1] = '\0'; break;
-                case 1: strncpy(r.phoneModel, val.c_str(), sizeof(r.phoneModel) - 1); r.phoneModel[sizeof(r.phoneModel) - 1] = '\0'; break;
-                case 2: strncpy(r.modelVariant, val.c_str(), sizeof(r.modelVariant) - 1); r.modelVariant[sizeof(r.modelVariant) - 1] = '\0'; break;
-                case 3: strncpy(r.startDate, val.c_str(), sizeof(r.startDate) - 1); r.startDate[sizeof(r.startDate) - 1] = '\0'; break;
-                case 4: strncpy(r.endDate, val.c_str(), sizeof(r.endDate) - 1); r.endDate[sizeof(r.endDate) - 1] = '\0'; break;
-                case 5: r.days = stoi(val); break;
-            }
-            pos = next + 1;
+        if (!parseLine(line, r)) continue;
+        batch.push_back(r);
+        if (batch.size() == 4096) invalid += storeBatch(batch);
+    }
+    invalid += storeBatch(batch);
+    if (invalid > 0) cout << "Warning: " << invalid << " record(s) in " << dataFile << " have an invalid name or date.\n";
+    enforceMemoryBudget();
+}
+
+// Validate the names and dates of a batch of loaded records a column at a time, then store them.
+// Invalid records are kept, since dropping them would delete them from the file on the next save.
+size_t RentalServiceSystem::storeBatch(vector<Rental> &batch) {
+    vector<const char *> names, starts, ends;
+    for (const Rental &r : batch) {
+        names.push_back(r.renterName);
+        starts.push_back(r.startDate);
+        ends.push_back(r.endDate);
+    }
+    vector<unsigned char> nameOk, startOk, endOk;
+    validateBatch(FIELD_NAME, names, nameOk);
+    validateBatch(FIELD_DATE, starts, startOk);
+    validateBatch(FIELD_DATE, ends, endOk);
+    size_t invalid = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!nameOk[i] || !startOk[i] || !endOk[i]) ++invalid;
+        storeRental(batch[i]);
+    }
+    batch.clear();
+    return invalid;
+}
+
+// Parse a rentals.txt line (name|model|variant|start|end|days|amount); false if a field is missing
+bool RentalServiceSystem::parseLine(const string &line, Rental &r) {
+    size_t pos = 0;
+    for (int i = 0; i < 6; ++i) {
+        size_t next = line.find('|', pos);
+        if (next == string::npos) return false;
+        string val = line.substr(pos, next - pos);
+        switch (i) {
+            case 0: strncpy(r.renterName, val.c_str(), sizeof(r.renterName) - 1); r.renterName[sizeof(r.renterName) - 1] = '\0'; break;
+            case 1: strncpy(r.phoneModel, val.c_str(), sizeof(r.phoneModel) - 1); r.phoneModel[sizeof(r.phoneModel) - 1] = '\0'; break;
+            case 2: strncpy(r.modelVariant, val.c_str(), sizeof(r.modelVariant) - 1); r.modelVariant[sizeof(r.modelVariant) - 1] = '\0'; break;
+            case 3: strncpy(r.startDate, val.c_str(), sizeof(r.startDate) - 1); r.startDate[sizeof(r.startDate) - 1] = '\0'; break;
+            case 4: strncpy(r.endDate, val.c_str(), sizeof(r.endDate) - 1); r.endDate[sizeof(r.endDate) - 1] = '\0'; break;
+            case 5: r.days = stoi(val); break;
         }
-        r.totalAmount = stoi(line.substr(pos));
-        rentals.push(r);
+        pos = next + 1;
     }
+    r.totalAmount = stoi(line.substr(pos));
+    return true;
+}
+
+// Index every live archived record; the records themselves stay on disk. archivedLines gets a
+// hash of each record's line, not the line, so a large archive doesn't overrun the budget loading.
+// With no memory budget the archive is only read if a previous run left one behind.
+void RentalServiceSystem::loadArchive(unordered_map<size_t, pair<long long, int>> &archivedLines) {
+    string path = dataFile.substr(0, dataFile.rfind('.')) + "_archive.bin";
+    if (memoryBudget == 0 && !ifstream(path)) return;
+    size_t cacheRecords = memoryBudget / 8 / (sizeof(Rental) + 64);
+    archive.open(path, cacheRecords, [&](long long offset, const Rental &r) {
+        int id = nextId++;
+        archived[id] = offset;
+        indexRental(id, r);
+        auto copies = archivedLines.emplace(hash<string>()(formatLine(r)), make_pair(offset, 0));
+        ++copies.first->second.second;
+    });
+}
+
+// Estimated bytes held for records: a resident record is kept twice (the store and the writer's
+// copy), and every record, archived or not, has name, start date, due date and renter index entries.
+// evicting counts that many resident records as already archived.
+size_t RentalServiceSystem::memoryInUse(size_t evicting) {
+    const size_t node = 48;          // Tree or hash node overhead
+    const size_t indexBytes = 4 * node + 64; // byName (with its string key), byStart, dueDates, renters
+    const size_t residentBytes = 2 * (sizeof(Rental) + node) + node + indexBytes; // Plus residentByEnd
+    const size_t archivedBytes = node + indexBytes; // Slot offset in archived
+    return (rentals.size() - evicting) * residentBytes + (archived.size() + evicting) * archivedBytes
+           + archive.cacheSize() * (sizeof(Rental) + 2 * node);
+}
+
+// Move closed rentals (end date already passed) to the archive, earliest first, until records and
+// indexes fit the memory budget. Active rentals always stay resident, and archived records keep
+// their index entries, so a budget smaller than those can't be met; that is reported once.
+// The archive is synced before the data file is told to drop the records, so a power cut can't
+// lose them from both. Evicting goes a little below the budget so the sync isn't paid on every add.
+void RentalServiceSystem::enforceMemoryBudget() {
+    if (memoryBudget == 0 || !archive.isOpen() || memoryInUse() <= memoryBudget) return;
+    int today = todayEpochDay();
+    size_t target = memoryBudget - memoryBudget / 16;
+    vector<pair<int, long long>> moved; // (record ID, archive offset)
+    while (memoryInUse(moved.size()) > target && !residentByEnd.empty() && residentByEnd.peek().first < today) {
+        int id = residentByEnd.peek().second;
+        long long offset = archive.append(rentals[id]);
+        if (offset < 0) {
+            cout << "Warning: could not write to the archive; keeping records in memory.\n";
+            break;
+        }
+        residentByEnd.remove(id);
+        moved.push_back({ id, offset });
+    }
+    if (!moved.empty() && !archive.sync()) {
+        cout << "Warning: could not sync the archive; keeping records in memory.\n";
+        for (const auto &entry : moved) {
+            archive.remove(entry.second);
+            residentByEnd.insert(entry.first, toEpochDay(rentals[entry.first].endDate));
+        }
+        return;
+    }
+    for (const auto &entry : moved) {
+        rentals.erase(entry.first);
+        archived[entry.first] = entry.second;
+        writer.submitEvict(entry.first); // The archive holds it now, so the data file can drop it
+    }
+    if (!budgetWarned && memoryInUse() > memoryBudget) {
+        budgetWarned = true;
+        cout << "Warning: active rentals and the indexes of archived ones need about " << memoryInUse() / (1024 * 1024)
+             << " MB, more than the " << memoryBudget / (1024 * 1024) << " MB budget.\n";
+    }
+}
+
+// Fetch a record from memory, or from the archive through its LRU cache
+Rental RentalServiceSystem::getRental(int id) {
+    auto it = rentals.find(id);
+    if (it != rentals.end()) return it->second;
+    return archive.read(archived[id]);
+}
+
+// Visit resident and archived records together in ID order.
+// Archived records are read straight from disk so a scan doesn't flush the cache.
+void RentalServiceSystem::forEachRecord(const function<void(int, const Rental &)> &visit) {
+    auto resident = rentals.begin();
+    auto cold = archived.begin();
+    while (resident != rentals.end() || cold != archived.end()) {
+        if (cold == archived.end() || (resident != rentals.end() && resident->first < cold->first)) {
+            visit(resident->first, resident->second);
+            ++resident;
+        } else {
+            visit(cold->first, archive.readUncached(cold->second));
+            ++cold;
+        }
+    }
+}
+
+// Number of records across both tiers
+size_t RentalServiceSystem::recordCount() {
+    return rentals.size() + archived.size();
+}
+
+// Limit memory used by records and their indexes (0 = unlimited)
+void RentalServiceSystem::setMemoryBudget(size_t bytes) {
+    memoryBudget = bytes;
+}
+
+// Store a record under a new ID and add it to the indexes
+int RentalServiceSystem::storeRental(const Rental &r) {
+    int id = nextId++;
+    rentals[id] = r;
+    indexRental(id, r);
+    residentByEnd.insert(id, toEpochDay(r.endDate));
+    return id;
+}
+
+// Lower-case a name and collapse runs of spaces, so "ana  CRUZ" and "Ana Cruz" are the same renter
+string RentalServiceSystem::normalizeName(const string &name) {
+    string key;
+    for (char c : name) {
+        if (c == ' ') {
+            if (!key.empty() && key.back() != ' ') key += ' ';
+        } else {
+            key += (char)tolower((unsigned char)c);
+        }
+    }
+    if (!key.empty() && key.back() == ' ') key.pop_back();
+    return key;
+}
+
+// Add a record to the name, start date, due date and renter indexes
+void RentalServiceSystem::indexRental(int id, const Rental &r) {
+    byName.insert({ r.renterName, id });
+    byStart.insert({ toEpochDay(r.startDate), id });
+    dueDates.insert(id, toEpochDay(r.endDate));
+    RenterProfile &profile = renters[normalizeName(r.renterName)];
+    if (profile.ids.empty()) profile.displayName = r.renterName;
+    profile.ids.push_back(id);
+    profile.lifetimeSpend += r.totalAmount;
+}
+
+// Remove a record from every index
+void RentalServiceSystem::unindexRental(int id, const Rental &r) {
+    auto names = byName.equal_range(r.renterName);
+    for (auto n = names.first; n != names.second; ++n) {
+        if (n->second == id) { byName.erase(n); break; }
+    }
+    auto starts = byStart.equal_range(toEpochDay(r.startDate));
+    for (auto d = starts.first; d != starts.second; ++d) {
+        if (d->second == id) { byStart.erase(d); break; }
+    }
+    dueDates.remove(id);
+    auto profile = renters.find(normalizeName(r.renterName));
+    if (profile != renters.end()) {
+        vector<int> &ids = profile->second.ids;
+        auto pos = find(ids.begin(), ids.end(), id);
+        if (pos != ids.end()) {
+            ids.erase(pos);
+            profile->second.lifetimeSpend -= r.totalAmount;
+        }
+        if (ids.empty()) renters.erase(profile);
+    }
+}
+
+// Remove a record and its index entries from whichever tier holds it
+void RentalServiceSystem::removeRental(int id) {
+    unindexRental(id, getRental(id));
+    residentByEnd.remove(id);
+    auto cold = archived.find(id);
+    if (cold != archived.end()) {
+        archive.remove(cold->second);
+        archived.erase(cold);
+    }
+    rentals.erase(id);
 }
 
 // Add a new rental record
@@ -180,9 +551,7 @@ void RentalServiceSystem::addRental() {
         cout << "Confirm rental? (yes/no): ";
         getline(cin, confirm);
         if (confirm == "yes") {
-            rentals.push(r);
-            saveToFile();
-            cout << "Rental record added successfully!\n";
+            addRecord(r);
             break;
         } else if (confirm == "no") {
             cout << "Rental cancelled. Returning to menu.\n";
@@ -193,20 +562,29 @@ void RentalServiceSystem::addRental() {
     }
 }
 
+// Store a confirmed rental and queue it for saving
+void RentalServiceSystem::addRecord(const Rental &r) {
+    writer.submitAdd(storeRental(r), r);
+    cout << "Rental record added successfully!\n";
+    enforceMemoryBudget();
+}
+
 // Display all rental records
 void RentalServiceSystem::displayAll() {
-    if (rentals.empty()) {
+    if (recordCount() == 0) {
         cout << "No records found.\n";
         return;
     }
-    queue<Rental> temp = rentals;
-    while (!temp.empty()) {
-        Rental &r = temp.front();
-        cout << "Renter: " << r.renterName << " | Phone: " << r.phoneModel << " (" << r.modelVariant << ")"
-             << " | Start: " << r.startDate << " | End: " << r.endDate
-             << " | Days: " << r.days << " | Amount: " << r.totalAmount << " pesos\n";
-        temp.pop();
-    }
+    forEachRecord([this](int, const Rental &r) {
+        printRental(r);
+    });
+}
+
+// Print one rental record on a single line
+void RentalServiceSystem::printRental(const Rental &r) {
+    cout << "Renter: " << r.renterName << " | Phone: " << r.phoneModel << " (" << r.modelVariant << ")"
+         << " | Start: " << r.startDate << " | End: " << r.endDate
+         << " | Days: " << r.days << " | Amount: " << r.totalAmount << " pesos\n";
 }
 
 // Display a specific rental by renter name or phone model
@@ -214,18 +592,20 @@ void RentalServiceSystem::displaySpecificRental() {
     string searchTermStr;
     cout << "Enter Renter Name or Phone Model to search: ";
     getline(cin, searchTermStr);
-    queue<Rental> temp = rentals;
+    findByNameOrModel(searchTermStr);
+}
+
+// Print every rental whose renter name or phone model matches
+void RentalServiceSystem::findByNameOrModel(const string &searchTermStr) {
     bool found = false;
-    while (!temp.empty()) {
-        Rental &r = temp.front();
+    forEachRecord([&](int, const Rental &r) {
         if (strcmp(r.renterName, searchTermStr.c_str()) == 0 || strcmp(r.phoneModel, searchTermStr.c_str()) == 0) {
             cout << "Record found:\nRenter: " << r.renterName << "\nPhone: " << r.phoneModel << " (" << r.modelVariant << ")"
                  << "\nStart: " << r.startDate << "\nEnd: " << r.endDate
                  << "\nDays: " << r.days << "\nAmount: " << r.totalAmount << " pesos\n";
             found = true;
         }
-        temp.pop();
-    }
+    });
     if (!found) {
         cout << "No record found with the given information.\n";
     }
@@ -236,24 +616,23 @@ void RentalServiceSystem::deleteRental() {
     string nameToDelete;
     cout << "Enter Renter Name to delete: ";
     getline(cin, nameToDelete);
-    queue<Rental> updated;
-    bool deleted = false;
-    while (!rentals.empty()) {
-        Rental r = rentals.front();
-        rentals.pop();
-        if (!deleted && strcmp(r.renterName, nameToDelete.c_str()) == 0) {
-            deleted = true;
-            continue;
-        }
-        updated.push(r);
-    }
-    rentals = updated;
-    if (deleted) {
-        cout << "Record deleted successfully.\n";
-        saveToFile();
-    } else {
+    deleteByName(nameToDelete);
+}
+
+// Delete the oldest rental with this renter name
+bool RentalServiceSystem::deleteByName(const string &nameToDelete) {
+    // The first match in insertion order is the oldest record with that name
+    auto it = byName.find(nameToDelete);
+    if (it == byName.end()) {
         cout << "No record found with the given Renter Name.\n";
+        return false;
     }
+    int id = it->second;
+    Rental removed = getRental(id);
+    removeRental(id);
+    writer.submitRemove(id, removed);
+    cout << "Record deleted successfully.\n";
+    return true;
 }
 
 // Search rental by renter name
@@ -261,24 +640,455 @@ void RentalServiceSystem::searchRental() {
     string name;
     cout << "\nEnter Renter Name to search: ";
     getline(cin, name);
-    bool found = false;
+    searchByName(name);
+}
 
-    queue<Rental> temp = rentals;
-    while (!temp.empty()) {
-        Rental r = temp.front();
-        temp.pop();
-        if (strcmp(r.renterName, name.c_str()) == 0) {
-            cout << "\nRental found:\nRenter: " << r.renterName << "\nPhone: " << r.phoneModel << " (" << r.modelVariant << ")"
-                 << "\nStart: " << r.startDate << "\nEnd: " << r.endDate
-                 << "\nDays: " << r.days << "\nAmount: " << r.totalAmount << " pesos\n";
-            found = true;
-            break;
+// Print the first rental with this renter name
+void RentalServiceSystem::searchByName(const string &name) {
+    auto it = byName.find(name);
+    if (it != byName.end()) {
+        Rental r = getRental(it->second);
+        cout << "\nRental found:\nRenter: " << r.renterName << "\nPhone: " << r.phoneModel << " (" << r.modelVariant << ")"
+             << "\nStart: " << r.startDate << "\nEnd: " << r.endDate
+             << "\nDays: " << r.days << "\nAmount: " << r.totalAmount << " pesos\n";
+    } else {
+        cout << "Rental not found.\n";
+    }
+}
+
+// Text value of a name/model/variant field
+const char *RentalServiceSystem::fieldText(const Rental &r, QueryField f) {
+    if (f == Q_NAME) return r.renterName;
+    if (f == Q_MODEL) return r.phoneModel;
+    return r.modelVariant;
+}
+
+// Numeric value of a date/days/amount field
+int RentalServiceSystem::fieldNumber(const Rental &r, QueryField f) {
+    if (f == Q_START) return toEpochDay(r.startDate);
+    if (f == Q_END) return toEpochDay(r.endDate);
+    if (f == Q_DAYS) return r.days;
+    return r.totalAmount;
+}
+
+// Check one predicate against a record
+bool RentalServiceSystem::matches(const Rental &r, const Predicate &p) {
+    int cmp;
+    if (isTextField(p.field)) {
+        cmp = strcmp(fieldText(r, p.field), p.text.c_str());
+    } else {
+        int value = fieldNumber(r, p.field);
+        cmp = value < p.number ? -1 : (value > p.number ? 1 : 0);
+    }
+    switch (p.op) {
+        case Q_EQ: return cmp == 0;
+        case Q_NE: return cmp != 0;
+        case Q_LT: return cmp < 0;
+        case Q_LE: return cmp <= 0;
+        case Q_GT: return cmp > 0;
+        default: return cmp >= 0;
+    }
+}
+
+// Choose the cheapest access path for a query and collect its candidate record IDs.
+// Costs are estimated row counts: exact for the name index, proportional to the
+// date span for the start-date index, and every record for a full scan.
+vector<int> RentalServiceSystem::planQuery(const Query &q, string &path) {
+    const Predicate *nameEq = nullptr;
+    int lo = numeric_limits<int>::min(), hi = numeric_limits<int>::max();
+    bool hasRange = false;
+    for (const Predicate &p : q.predicates) {
+        if (p.field == Q_NAME && p.op == Q_EQ) nameEq = &p;
+        if (p.field != Q_START) continue;
+        if (p.op == Q_EQ) { lo = max(lo, p.number); hi = min(hi, p.number); hasRange = true; }
+        else if (p.op == Q_GE) { lo = max(lo, p.number); hasRange = true; }
+        else if (p.op == Q_GT) { lo = max(lo, p.number + 1); hasRange = true; }
+        else if (p.op == Q_LE) { hi = min(hi, p.number); hasRange = true; }
+        else if (p.op == Q_LT) { hi = min(hi, p.number - 1); hasRange = true; }
+    }
+
+    double scanCost = (double)recordCount();
+    double nameCost = nameEq ? (double)byName.count(nameEq->text) : scanCost + 1;
+    double rangeCost = scanCost + 1;
+    if (hasRange && !byStart.empty()) {
+        double first = byStart.begin()->first, last = byStart.rbegin()->first;
+        double from = max((double)lo, first), to = min((double)hi, last);
+        rangeCost = to < from ? 0 : scanCost * (to - from + 1) / (last - first + 1);
+    }
+
+    vector<int> ids;
+    if (nameCost <= rangeCost && nameCost <= scanCost) {
+        path = "name index";
+        auto range = byName.equal_range(nameEq->text);
+        for (auto it = range.first; it != range.second; ++it) ids.push_back(it->second);
+    } else if (rangeCost <= scanCost) {
+        path = "start date range";
+        for (auto it = byStart.lower_bound(lo); it != byStart.end() && it->first <= hi; ++it) ids.push_back(it->second);
+        sort(ids.begin(), ids.end()); // Keep results in insertion order
+    } else {
+        path = "full scan";
+        ids.reserve(recordCount());
+        for (const auto &entry : rentals) ids.push_back(entry.first);
+        for (const auto &entry : archived) ids.push_back(entry.first);
+        sort(ids.begin(), ids.end());
+    }
+    return ids;
+}
+
+// Parse, plan and run a query, then print the matching records
+void RentalServiceSystem::executeQuery(const string &text) {
+    Query q;
+    string error;
+    if (!parseQuery(text, q, error)) {
+        cout << "Invalid query: " << error << "\n";
+        return;
+    }
+
+    string path;
+    vector<int> candidates = planQuery(q, path);
+
+    // Each record is fetched once: resident ones in place, archived ones straight from disk like
+    // forEachRecord does, so a query doesn't flush the archive cache.
+    const size_t batchSize = 256;
+    vector<Rental> coldRows(batchSize); // Archived candidates of the current batch
+    auto fetch = [&](int id, Rental &cold) -> const Rental * {
+        auto resident = rentals.find(id);
+        if (resident != rentals.end()) return &resident->second;
+        cold = archive.readUncached(archived.find(id)->second);
+        return &cold;
+    };
+
+    // Evaluate one predicate at a time over batches of fetched candidates, compacting survivors in
+    // place, and keep the sort key of each match. Without a sort, a limit lets us stop as soon as
+    // enough matches are found.
+    struct Match {
+        int id;
+        string text;    // Sort key for text fields
+        int number = 0; // Sort key for numeric fields
+    };
+    vector<Match> results;
+    vector<pair<int, const Rental *>> batch(batchSize);
+    for (size_t start = 0; start < candidates.size(); start += batchSize) {
+        size_t count = min(batchSize, candidates.size() - start);
+        for (size_t i = 0; i < count; ++i) batch[i] = { candidates[start + i], fetch(candidates[start + i], coldRows[i]) };
+        for (const Predicate &p : q.predicates) {
+            size_t kept = 0;
+            for (size_t i = 0; i < count; ++i) {
+                if (matches(*batch[i].second, p)) batch[kept++] = batch[i];
+            }
+            count = kept;
         }
+        for (size_t i = 0; i < count; ++i) {
+            Match m;
+            m.id = batch[i].first;
+            if (q.sorted && isTextField(q.sortField)) m.text = fieldText(*batch[i].second, q.sortField);
+            else if (q.sorted) m.number = fieldNumber(*batch[i].second, q.sortField);
+            results.push_back(move(m));
+        }
+        if (!q.sorted && q.limit >= 0 && (int)results.size() >= q.limit) break;
     }
 
-    if (!found) {
-        cout << "Rental not found.\n";
+    if (q.sorted) {
+        bool text = isTextField(q.sortField);
+        stable_sort(results.begin(), results.end(), [&](const Match &a, const Match &b) {
+            int cmp = text ? a.text.compare(b.text) : (a.number < b.number ? -1 : (a.number > b.number ? 1 : 0));
+            return q.descending ? cmp > 0 : cmp < 0;
+        });
+    }
+    if (q.limit >= 0 && (int)results.size() > q.limit) results.resize(q.limit);
+
+    cout << "Access path: " << path << " (" << candidates.size() << " of " << recordCount() << " records read)\n";
+    for (const Match &m : results) printRental(*fetch(m.id, coldRows[0]));
+    cout << results.size() << " record(s) matched.\n";
+}
+
+// Ask for a query and run it
+void RentalServiceSystem::queryRentals() {
+    string text;
+    cout << "Fields: name, model, variant, start, end, days, amount. Operators: = != < <= > >=\n";
+    cout << "Example: model=iPhone 16 AND start>=01/01/2025 AND amount>10000 SORT amount DESC LIMIT 5\n";
+    cout << "Enter query: ";
+    getline(cin, text);
+    executeQuery(text);
+}
+
+// List rentals due back today
+void RentalServiceSystem::showDueToday() {
+    int today = todayEpochDay();
+    dueDates.advanceTo(today);
+    vector<pair<int, int>> due = dueDates.upcomingUntil(today, dueDates.size());
+    for (const auto &entry : due) printRental(getRental(entry.second));
+    cout << due.size() << " rental(s) due today.\n";
+}
+
+// List rentals past their end date, most overdue first
+void RentalServiceSystem::showOverdue() {
+    int today = todayEpochDay();
+    dueDates.advanceTo(today);
+    vector<pair<int, int>> overdue = dueDates.overdue();
+    for (const auto &entry : overdue) {
+        cout << "[" << today - entry.first << " day(s) overdue] ";
+        printRental(getRental(entry.second));
     }
+    cout << overdue.size() << " overdue rental(s).\n";
+}
+
+// List the next N rentals due back, starting from today
+void RentalServiceSystem::showNextReturns() {
+    string input;
+    cout << "How many upcoming returns to show? ";
+    getline(cin, input);
+    int n;
+    try {
+        n = stoi(input);
+    } catch (...) {
+        n = 0;
+    }
+    if (n <= 0) {
+        cout << "Invalid number.\n";
+        return;
+    }
+    listNextReturns(n);
+}
+
+// Print the next n rentals due back, starting from today
+void RentalServiceSystem::listNextReturns(int n) {
+    // Overdue rentals are kept in their own heap, so this touches only the n returned
+    dueDates.advanceTo(todayEpochDay());
+    vector<pair<int, int>> next = dueDates.upcomingUntil(numeric_limits<int>::max(), n);
+    for (const auto &entry : next) printRental(getRental(entry.second));
+    if (next.empty()) cout << "No upcoming returns.\n";
+}
+
+// Run one protocol command line. Commands:
+//   ADD name|model|variant|MM/DD/YYYY|MM/DD/YYYY   DELETE name   SEARCH name   FIND name-or-model
+//   PROFILE name   LOOKUP name   LIST   QUERY query   DUE   OVERDUE   NEXT n   EXPORT file [key,key,...]
+//   FLUSH   WAIT ms
+// Blank lines and lines starting with # are ignored. Returns false if the command failed.
+bool RentalServiceSystem::executeCommand(const string &line) {
+    if (line.empty() || line[0] == '#') return true;
+    size_t space = line.find(' ');
+    string command = line.substr(0, space);
+    string args = space == string::npos ? "" : line.substr(space + 1);
+
+    if (command == "ADD") {
+        string fields[5];
+        size_t pos = 0;
+        for (int i = 0; i < 5; ++i) {
+            size_t next = i < 4 ? args.find('|', pos) : string::npos;
+            if (i < 4 && next == string::npos) {
+                cout << "ERROR: ADD needs name|model|variant|start|end\n";
+                return false;
+            }
+            fields[i] = args.substr(pos, next == string::npos ? string::npos : next - pos);
+            pos = next + 1;
+        }
+        if (!isValidName(fields[0]) || !isValidVariant(fields[1], fields[2])
+            || !isValidDate(fields[3]) || !isValidDate(fields[4])) {
+            cout << "ERROR: invalid rental \"" << args << "\"\n";
+            return false;
+        }
+        Rental r;
+        strncpy(r.renterName, fields[0].c_str(), sizeof(r.renterName) - 1); r.renterName[sizeof(r.renterName) - 1] = '\0';
+        strncpy(r.phoneModel, fields[1].c_str(), sizeof(r.phoneModel) - 1); r.phoneModel[sizeof(r.phoneModel) - 1] = '\0';
+        strncpy(r.modelVariant, fields[2].c_str(), sizeof(r.modelVariant) - 1); r.modelVariant[sizeof(r.modelVariant) - 1] = '\0';
+        strncpy(r.startDate, fields[3].c_str(), sizeof(r.startDate) - 1); r.startDate[sizeof(r.startDate) - 1] = '\0';
+        strncpy(r.endDate, fields[4].c_str(), sizeof(r.endDate) - 1); r.endDate[sizeof(r.endDate) - 1] = '\0';
+        r.days = calculateDays(r.startDate, r.endDate);
+        r.totalAmount = r.days * 2000;
+        addRecord(r);
+        return true;
+    }
+    if (command == "DELETE") return deleteByName(args);
+    if (command == "SEARCH") { searchByName(args); return true; }
+    if (command == "FIND") { findByNameOrModel(args); return true; }
+    if (command == "PROFILE") { showProfile(args); return true; }
+    if (command == "LOOKUP") { lookupByName(args); return true; }
+    if (command == "LIST") { displayAll(); return true; }
+    if (command == "QUERY") { executeQuery(args); return true; }
+    if (command == "DUE") { showDueToday(); return true; }
+    if (command == "OVERDUE") { showOverdue(); return true; }
+    if (command == "NEXT") {
+        int n = atoi(args.c_str());
+        if (n <= 0) {
+            cout << "ERROR: NEXT needs a positive number\n";
+            return false;
+        }
+        listNextReturns(n);
+        return true;
+    }
+    if (command == "EXPORT") {
+        size_t split = args.find(' ');
+        return exportSorted(args.substr(0, split), split == string::npos ? "" : args.substr(split + 1));
+    }
+    if (command == "FLUSH") {
+        bool saved = writer.flush();
+        reportWriteErrors();
+        return saved;
+    }
+    if (command == "WAIT") {
+        this_thread::sleep_for(chrono::milliseconds(atoi(args.c_str())));
+        return true;
+    }
+    cout << "ERROR: unknown command \"" << command << "\"\n";
+    return false;
+}
+
+// Print every rental a renter has made with their lifetime totals.
+// Costs one hash lookup plus the renter's own history, however large the store is.
+void RentalServiceSystem::showProfile(const string &name) {
+    auto it = renters.find(normalizeName(name));
+    if (it == renters.end()) {
+        cout << "No rentals found for " << name << ".\n";
+        return;
+    }
+    const RenterProfile &profile = it->second;
+    cout << "Customer: " << profile.displayName << "\n";
+    cout << "Rentals: " << profile.ids.size() << " | Lifetime spend: " << profile.lifetimeSpend << " pesos\n";
+    for (int id : profile.ids) printRental(getRental(id));
+}
+
+// Ask for a renter name and show their profile
+void RentalServiceSystem::customerProfile() {
+    string name;
+    cout << "Enter Renter Name: ";
+    getline(cin, name);
+    showProfile(name);
+}
+
+// Record in the rentals.txt line format
+string RentalServiceSystem::formatLine(const Rental &r) {
+    return string(r.renterName) + "|" + r.phoneModel + "|" + r.modelVariant + "|" + r.startDate + "|"
+           + r.endDate + "|" + to_string(r.days) + "|" + to_string(r.totalAmount);
+}
+
+// Append one record's sort keys to a batch
+void RentalServiceSystem::addToBatch(ExportBatch &batch, const vector<QueryField> &keys, int id, const Rental &r) {
+    batch.ids.push_back(id);
+    for (size_t k = 0; k < keys.size(); ++k) {
+        if (isTextField(keys[k])) batch.text[k].push_back(fieldText(r, keys[k]));
+        else batch.numbers[k].push_back((uint32_t)fieldNumber(r, keys[k]) ^ 0x80000000u); // Signed -> unsigned order
+    }
+}
+
+// Dictionary-encode the text keys, then radix sort the batch's permutation on all key columns
+vector<int> RentalServiceSystem::sortBatch(ExportBatch &batch, const vector<QueryField> &keys, int threads) {
+    vector<vector<uint32_t>> columns(keys.size());
+    for (size_t k = 0; k < keys.size(); ++k) {
+        if (isTextField(keys[k])) columns[k] = dictionaryEncode(batch.text[k], threads);
+        else columns[k] = batch.numbers[k];
+    }
+    return radixSortColumns(columns, batch.ids.size(), threads);
+}
+
+// Key that compares byte-wise in the same order the batch sort uses, ending in the record ID
+// so ties across runs keep insertion order just like the in-memory sort
+string RentalServiceSystem::runKey(const ExportBatch &batch, const vector<QueryField> &keys, size_t row) {
+    string key;
+    char hex[16];
+    for (size_t k = 0; k < keys.size(); ++k) {
+        if (isTextField(keys[k])) {
+            key += batch.text[k][row];
+            key += '\x01'; // Sorts before any name character, so "Ann" < "Anna"
+        } else {
+            snprintf(hex, sizeof(hex), "%08x", batch.numbers[k][row]);
+            key += hex;
+        }
+    }
+    snprintf(hex, sizeof(hex), "%010d", batch.ids[row]);
+    return key + hex;
+}
+
+// Write every record to path sorted by comma-separated keys (default model,variant,start,name).
+// Sorting works on a permutation of row numbers. If the keys for every record would not fit the
+// memory budget, sorted runs are written to disk and merged.
+bool RentalServiceSystem::exportSorted(const string &path, const string &keySpec) {
+    vector<QueryField> keys;
+    string spec = keySpec.empty() ? "model,variant,start,name" : keySpec;
+    for (size_t pos = 0; pos <= spec.size();) {
+        size_t comma = spec.find(',', pos);
+        string name = trimSpaces(spec.substr(pos, comma == string::npos ? string::npos : comma - pos));
+        QueryField field;
+        if (!parseField(name, field)) {
+            cout << "ERROR: unknown sort key \"" << name << "\"\n";
+            return false;
+        }
+        keys.push_back(field);
+        if (comma == string::npos) break;
+        pos = comma + 1;
+    }
+    if (path.empty()) {
+        cout << "ERROR: EXPORT needs a file name\n";
+        return false;
+    }
+
+    ofstream out(path);
+    if (!out) {
+        cout << "ERROR: cannot write " << path << "\n";
+        return false;
+    }
+    int threads = max(1, (int)thread::hardware_concurrency());
+    size_t limit = memoryBudget ? memoryBudget : (size_t)256 * 1024 * 1024;
+    size_t perRow = keys.size() * 48 + sizeof(Rental) + 32; // Keys, dictionary and permutation space, plus line text
+    size_t runRows = max((size_t)1024, limit / perRow);
+    auto newBatch = [&]() {
+        ExportBatch batch;
+        batch.text.resize(keys.size());
+        batch.numbers.resize(keys.size());
+        return batch;
+    };
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+
+    size_t total = recordCount();
+    size_t written = 0; // Rows that reached the export file
+    vector<string> runFiles;
+    if (total <= runRows) {
+        ExportBatch batch = newBatch();
+        forEachRecord([&](int id, const Rental &r) { addToBatch(batch, keys, id, r); });
+        for (int row : sortBatch(batch, keys, threads)) {
+            out << formatLine(getRental(batch.ids[row])) << '\n';
+            ++written;
+        }
+    } else {
+        ExportBatch batch = newBatch();
+        size_t spilled = 0;
+        bool runsWritten = true;
+        auto spill = [&]() {
+            vector<int> order = sortBatch(batch, keys, threads);
+            string runFile = path + ".run" + to_string(runFiles.size());
+            runFiles.push_back(runFile);
+            ofstream run(runFile);
+            for (int row : order) run << runKey(batch, keys, row) << '\t' << batch.lines[row] << '\n';
+            run.close();
+            if (!run) runsWritten = false;
+            spilled += order.size();
+            batch = newBatch();
+        };
+        forEachRecord([&](int id, const Rental &r) {
+            if (!runsWritten) return; // A run is already short; the export has failed
+            addToBatch(batch, keys, id, r);
+            batch.lines.push_back(formatLine(r));
+            if (batch.ids.size() >= runRows) spill();
+        });
+        if (runsWritten && !batch.ids.empty()) spill();
+        bool merged = runsWritten && mergeRuns(runFiles, out, written) && written == spilled;
+        for (const string &runFile : runFiles) remove(runFile.c_str());
+        if (!merged) {
+            cout << "ERROR: sorted runs for " << path << " could not be written or merged (" << written
+                 << " of " << total << " record(s) exported)\n";
+            return false;
+        }
+    }
+    out.close();
+    if (!out) {
+        cout << "ERROR: writing " << path << " failed\n";
+        return false;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    cout << "Exported " << written << " record(s) to " << path << " in " << seconds << " s"
+         << (runFiles.empty() ? "" : " (" + to_string(runFiles.size()) + " sorted runs merged)") << ".\n";
+    return true;
 }
 
 // Display group info
@@ -292,12 +1102,16 @@ void RentalServiceSystem::displayGroupInfo() {
 // Show menu and handle user input
 void RentalServiceSystem::showMenu() {
     int choice;
+    string input;
     do {
         cout << "\n===============\nMobile Phone Rental Service\n";
-        cout << "1. Add New Rental\n2. Search Rental\n3. Display All Rentals\n4. Display Specific Rental\n5. Delete Rental\n6. Exit\n";
+        cout << "1. Add New Rental\n2. Search Rental\n3. Display All Rentals\n4. Display Specific Rental\n5. Delete Rental\n6. Query Rentals\n"
+             << "7. Due Today\n8. Overdue Rentals\n9. Next Returns\n10. Customer Profile\n0. Exit\n";
         cout << "===============\nEnter choice: ";
-        cin >> choice;
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        // Read whole lines so later getline prompts never see a leftover newline
+        if (!getline(cin, input)) break;
+        choice = input.empty() ? -1 : atoi(input.c_str());
+        if (input != "0" && choice == 0) choice = -1;
 
         switch (choice) {
             case 1: addRental(); break;
@@ -305,21 +1119,553 @@ void RentalServiceSystem::showMenu() {
             case 3: displayAll(); break;
             case 4: displaySpecificRental(); break;
             case 5: deleteRental(); break;
-            case 6: cout << "Exiting...\n"; displayGroupInfo(); break;
+            case 6: queryRentals(); break;
+            case 7: showDueToday(); break;
+            case 8: showOverdue(); break;
+            case 9: showNextReturns(); break;
+            case 10: customerProfile(); break;
+            case 0: cout << "Exiting...\n"; displayGroupInfo(); break;
             default: cout << "Invalid choice. Try again.\n";
         }
-    } while (choice != 6);
+        reportWriteErrors();
+    } while (choice != 0);
+
+    // Make sure every change is on disk before the program ends
+    writer.flush();
+    reportWriteErrors();
 }
 
 // Run the system
-void RentalServiceSystem::run() {
+int RentalServiceSystem::run() {
     loadFromFile(); // Load rentals from file when program starts
+    startWriter();
     showMenu();     // Show the menu to user for further operations
+    return stopBackground() ? 0 : 1;
+}
+
+// Start background saving, beginning from the records already loaded.
+// Each mutation is appended to the change log on the writer thread, and the log
+// is flushed once per burst before the data file is rewritten. The same thread
+// feeds the name store, whose memtable the change log covers until it is flushed.
+void RentalServiceSystem::startWriter() {
+    changeLog.open(changeLogPrefix(), 4 * 1024 * 1024);
+    syncNameStore(false);
+    if (replicationPort > 0) {
+        // New followers start from the data file, so make sure it records its change log position.
+        // This runs before the writer thread exists, since saveToFile uses state only it may touch.
+        string error;
+        if (!saveToFile(rentals, error)) cout << "Warning: saving failed (" << error << ").\n";
+    }
+    writer.start(rentals, [this](const map<int, Rental> &records, string &error) {
+        // The snapshot records the log's last sequence, so the log must be on disk first
+        unsigned long long logged = changeLog.lastSequence();
+        if (!changeLog.flush(true)) {
+            error = "could not write the change log";
+            return false;
+        }
+        if (!saveToFile(records, error)) return false;
+        // Startup replays the log only past the data file and the name store's saved position
+        changeLog.removeSegmentsThrough(min(logged, nameStore.savedSequence()), 4);
+        return true;
+    }, [this](int id, const Rental *before, const Rental *after) {
+        unsigned long long seq;
+        if (!after) seq = changeLog.append(CHANGE_DELETE, id, *before);
+        else seq = changeLog.append(before ? CHANGE_UPDATE : CHANGE_ADD, id, *after);
+        if (before) nameStore.add(nameStoreKey(*before), -1, seq);
+        if (after) nameStore.add(nameStoreKey(*after), 1, seq);
+        replicationLeader.noteSequence(seq);
+    });
+    if (replicationPort > 0) {
+        if (replicationLeader.start(replicationHost, replicationPort, replicationSecret(), changeLogPrefix(),
+                                    [this](vector<Rental> &records) { return replicationSnapshot(records); })) {
+            cout << "Leading replication on " << replicationHost << ":" << replicationPort << "\n";
+        } else {
+            cout << "Warning: could not listen on " << replicationHost << ":" << replicationPort << "; replication is off.\n";
+        }
+    }
+}
+
+// Stop the background threads once every change has been saved, or the writer has given up
+bool RentalServiceSystem::stopBackground() {
+    bool saved = writer.stop();
+    nameStore.close();
+    replicationLeader.stop();
+    if (!saved) {
+        string error = writer.takeError();
+        cout << "Error: some changes could not be saved to " << dataFile << (error.empty() ? "" : " (" + error + ")") << ".\n";
+    }
+    return saved;
+}
+
+// Lead replication once the writer starts: accept followers on a port, on loopback unless a host is
+// given. Listening anywhere else needs RENTAL_REPLICATION_SECRET, since followers get every record.
+bool RentalServiceSystem::setReplicationAddress(const string &address) {
+    size_t colon = address.rfind(':');
+    string host = colon == string::npos ? "127.0.0.1" : address.substr(0, colon);
+    int port = atoi(address.c_str() + (colon == string::npos ? 0 : colon + 1));
+    if (port <= 0 || port > 65535) {
+        cout << "Use --leader [<host>:]<port>\n";
+        return false;
+    }
+    if (host != "127.0.0.1" && replicationSecret().empty()) {
+        cout << "Set RENTAL_REPLICATION_SECRET before leading on " << host << "; followers must send the same secret.\n";
+        return false;
+    }
+    replicationHost = host;
+    replicationPort = port;
+    return true;
+}
+
+// Read the newest snapshot for a new follower (on a replication thread, so only the file is used).
+// Returns the last change log sequence the snapshot includes. Archived records are not in the
+// data file, which is why main doesn't allow --leader together with --memory.
+unsigned long long RentalServiceSystem::replicationSnapshot(vector<Rental> &records) {
+    ifstream file(dataFile);
+    unsigned long long seq = 0;
+    string line;
+    while (getline(file, line)) {
+        if (line.compare(0, 10, "#snapshot ") == 0) {
+            sscanf(line.c_str(), "#snapshot %*u %*u %*x %llu", &seq);
+            continue;
+        }
+        Rental r;
+        if (parseLine(line, r)) records.push_back(r);
+    }
+    return seq;
+}
+
+// Follow a leader and answer read-only commands from stdin until it ends.
+// Replicated changes are applied on the follower thread; commands wait for the batch in progress.
+// Deletes are matched by record content, since record IDs differ between the leader's runs.
+int RentalServiceSystem::runFollower(const string &leader) {
+    size_t colon = leader.rfind(':');
+    if (colon == string::npos || atoi(leader.c_str() + colon + 1) <= 0) {
+        cout << "Use --follow <host>:<port>\n";
+        return 1;
+    }
+    mutex storeMutex;
+    unordered_map<string, vector<int>> replicaIds; // Record line -> local IDs, oldest first
+    ReplicationFollower<Rental> follower;
+    follower.start(leader.substr(0, colon), atoi(leader.c_str() + colon + 1), replicationSecret(), [&](const vector<ChangeEvent<Rental>> &events) {
+        lock_guard<mutex> lk(storeMutex);
+        for (const ChangeEvent<Rental> &e : events) {
+            if (e.type != CHANGE_DELETE) {
+                replicaIds[formatLine(e.record)].push_back(storeRental(e.record));
+                continue;
+            }
+            auto match = replicaIds.find(formatLine(e.record));
+            if (match == replicaIds.end()) continue;
+            removeRental(match->second.front());
+            match->second.erase(match->second.begin());
+            if (match->second.empty()) replicaIds.erase(match);
+        }
+    }, [&] {
+        lock_guard<mutex> lk(storeMutex);
+        for (const auto &entry : replicaIds) {
+            for (int id : entry.second) removeRental(id);
+        }
+        replicaIds.clear();
+    });
+
+    string line;
+    while (getline(cin, line)) {
+        string command = line.substr(0, line.find(' '));
+        if (command == "ADD" || command == "DELETE" || command == "FLUSH") {
+            cout << "ERROR: this is a read-only replica\n";
+        } else if (command == "LAG") {
+            size_t records;
+            {
+                lock_guard<mutex> lk(storeMutex); // The follower thread is changing the store
+                records = recordCount();
+            }
+            printReplicationStats(follower.snapshotStats(), records);
+        } else if (command == "WAIT") {
+            executeCommand(line);
+        } else {
+            lock_guard<mutex> lk(storeMutex);
+            executeCommand(line);
+        }
+    }
+    follower.stop();
+    printReplicationStats(follower.snapshotStats(), recordCount());
+    return 0;
+}
+
+// Print how far behind the leader this follower is and how fast it has been applying changes.
+// The compression ratio only counts frames with events, since heartbeats carry none.
+void RentalServiceSystem::printReplicationStats(const ReplicationStats &stats, size_t records) {
+    cout << "Replica at change " << stats.appliedSeq << " of " << stats.leaderSeq << " ("
+         << (stats.leaderSeq > stats.appliedSeq ? stats.leaderSeq - stats.appliedSeq : 0) << " behind), "
+         << (stats.connected ? "connected" : "not connected") << ", " << records << " records\n";
+    cout << "Received " << stats.events << " events in " << stats.batches << " batches, "
+         << stats.wireBytes << " bytes on the wire for " << stats.rawBytes << " bytes of events";
+    if (stats.eventWireBytes > 0) cout << " (" << (double)stats.rawBytes / stats.eventWireBytes << "x compression)";
+    cout << "\nSend-to-apply delay: last " << stats.lastDelayMs << " ms, worst " << stats.maxDelayMs << " ms\n";
+    if (stats.catchUpSeconds >= 0) {
+        cout << "Caught up with " << stats.catchUpEvents << " events in " << stats.catchUpSeconds << " s";
+        if (stats.catchUpSeconds > 0) cout << " (" << (long long)(stats.catchUpEvents / stats.catchUpSeconds) << " events/s)";
+        cout << "\n";
+    } else {
+        cout << "Still catching up\n";
+    }
+}
+
+// Name store segments sit next to the data file, e.g. rentals_names/
+string RentalServiceSystem::nameStoreDir() {
+    size_t dot = dataFile.rfind('.');
+    return dataFile.substr(0, dot) + "_names";
+}
+
+// Key under which a record is counted: the renter lookup prefix, then the record's line
+string RentalServiceSystem::nameStoreKey(const Rental &r) {
+    return normalizeName(r.renterName) + '\x01' + formatLine(r);
+}
+
+// Open the name store and bring it up to date. The first time, or if its files are damaged, it is
+// built from every loaded record; otherwise only the change log events it hasn't applied yet are
+// replayed. Returns false, leaving the store closed, if it needs building but was opened read-only.
+bool RentalServiceSystem::syncNameStore(bool readOnly) {
+    if (!nameStore.open(nameStoreDir(), readOnly)) {
+        string note = nameStore.takeError();
+        if (readOnly) {
+            nameStore.close();
+            return false;
+        }
+        if (!note.empty()) cout << "Note: " << note << ".\n";
+        unsigned long long seq = lastChangeSequence<Rental>(changeLogPrefix());
+        forEachRecord([&](int, const Rental &r) { nameStore.add(nameStoreKey(r), 1, seq); });
+        nameStore.flush();
+        return true;
+    }
+    ChangeCursor<Rental> cursor(changeLogPrefix(), nameStore.appliedSequence() + 1);
+    vector<ChangeEvent<Rental>> batch;
+    while (cursor.read(batch, 1000) > 0) {
+        for (const ChangeEvent<Rental> &e : batch) {
+            nameStore.add(nameStoreKey(e.record), e.type == CHANGE_DELETE ? -1 : 1, e.seq);
+        }
+        batch.clear();
+    }
+    return true;
+}
+
+// Print every rental for a renter straight from the name store, with the block reads it took.
+// A renter with no rentals is usually turned away by the Bloom filters without any reads.
+// The writer thread feeds the store, so changes made so far are waited for first.
+void RentalServiceSystem::lookupByName(const string &name) {
+    if (!nameStore.isOpen()) {
+        cout << "ERROR: the name store is not open\n";
+        return;
+    }
+    writer.flush();
+    int reads = 0;
+    vector<pair<string, long long>> found = nameStore.scanPrefix(normalizeName(name) + '\x01', reads);
+    long long count = 0;
+    for (const auto &entry : found) {
+        Rental r;
+        if (!parseLine(entry.first.substr(entry.first.find('\x01') + 1), r)) continue;
+        for (long long i = 0; i < entry.second; ++i) printRental(r);
+        count += entry.second;
+    }
+    if (count == 0) cout << "No rentals found for " << name << ".\n";
+    cout << count << " rental(s), " << reads << " disk read(s)\n";
+}
+
+// Look a renter up without loading rentals.txt. Only a run that has to build the store (the
+// first, or after damage) loads the records; others replay recent changes into memory and leave
+// the files alone.
+void RentalServiceSystem::runLookup(const string &name) {
+    if (!syncNameStore(true)) {
+        loadFromFile();
+        syncNameStore(false);
+    }
+    lookupByName(name);
+    nameStore.close();
+}
+
+// Change log segments sit next to the data file, e.g. rentals_changes_<seq>.log
+string RentalServiceSystem::changeLogPrefix() {
+    size_t dot = dataFile.rfind('.');
+    return dataFile.substr(0, dot) + "_changes_";
+}
+
+// Print every change since the offset saved in offsetFile, reading in batches, then save the new offset
+void RentalServiceSystem::runChangeFeed(const string &offsetFile, int batchSize) {
+    unsigned long long offset = 1;
+    {
+        ifstream in(offsetFile);
+        in >> offset;
+    }
+
+    unsigned long long oldest = firstChangeSequence(changeLogPrefix());
+    if (offset < oldest) {
+        cout << "Warning: changes " << offset << " to " << oldest - 1 << " were removed from the log before this reader saw them.\n";
+    }
+    ChangeCursor<Rental> cursor(changeLogPrefix(), offset);
+    vector<ChangeEvent<Rental>> batch;
+    size_t total = 0;
+    while (cursor.read(batch, batchSize > 0 ? batchSize : 100) > 0) {
+        for (const ChangeEvent<Rental> &e : batch) {
+            const Rental &r = e.record;
+            const char *type = e.type == CHANGE_ADD ? "ADD" : (e.type == CHANGE_UPDATE ? "UPDATE" : "DELETE");
+            cout << e.seq << " " << type << " " << e.id << " " << r.renterName << "|" << r.phoneModel << "|"
+                 << r.modelVariant << "|" << r.startDate << "|" << r.endDate << "|" << r.days << "|" << r.totalAmount << "\n";
+        }
+        total += batch.size();
+        batch.clear();
+    }
+
+    ofstream out(offsetFile);
+    out << cursor.position() << "\n";
+    cout << total << " change(s). Next offset " << cursor.position() << " saved to " << offsetFile << "\n";
+}
+
+// Run a single query from the command line
+void RentalServiceSystem::runQuery(const string &text) {
+    loadFromFile();
+    executeQuery(text);
+}
+
+// Load records and write them sorted to a file
+bool RentalServiceSystem::runExport(const string &path, const string &keySpec) {
+    loadFromFile();
+    return exportSorted(path, keySpec);
+}
+
+// Run protocol commands from a file or stdin; returns the number of failed commands
+int RentalServiceSystem::runScript(const string &path) {
+    ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            cout << "Cannot open script " << path << "\n";
+            return 1;
+        }
+    }
+    istream &in = path == "-" ? cin : file;
+
+    loadFromFile();
+    startWriter();
+    int failures = 0;
+    string line;
+    while (getline(in, line)) {
+        if (!executeCommand(line)) ++failures;
+    }
+    writer.flush();
+    reportWriteErrors();
+    if (!stopBackground()) ++failures;
+    return failures;
+}
+
+// Replay a workload through the command layer and report throughput and latency.
+// Uses its own data file, starting empty, so a test run never touches rentals.txt.
+bool RentalServiceSystem::runLoadTest(int count, double rate, const string &path) {
+    vector<string> commands;
+    if (path.empty()) {
+        commands = syntheticWorkload(count, 12345);
+    } else {
+        ifstream file(path);
+        string line;
+        while (getline(file, line) && (count <= 0 || (int)commands.size() < count)) commands.push_back(line);
+    }
+
+    dataFile = "loadtest_rentals.txt";
+    startWriter();
+    ostringstream discarded;
+    streambuf *console = cout.rdbuf(discarded.rdbuf());
+    runLoad(commands, rate, [this, &discarded](const string &line) {
+        executeCommand(line);
+        discarded.str("");
+    });
+    cout.rdbuf(console);
+
+    writer.flush();
+    reportWriteErrors();
+    bool saved = stopBackground();
+    cout << "Records after run: " << recordCount() << " (saved to " << dataFile << ")\n";
+    return saved;
+}
+
+// Save the same synthetic records with the old ofstream << chain and with saveToFile, best of
+// three runs each, and check that both produce the same record lines. Then keep submitting changes
+// while the writer thread takes snapshots, timing how long each submit holds up the caller.
+// Uses scratch files, not rentals.txt.
+void RentalServiceSystem::runSaveBenchmark(int count) {
+    const char *names[] = { "Ana Cruz", "Juan Dela Cruz", "Maria Santos", "Jose Rizal Reyes", "Liza Soberano" };
+    const char *models[][2] = { { "iPhone 16", "pro max" }, { "Samsung Galaxy S25", "ultra" }, { "iPhone 16", "base" } };
+    map<int, Rental> records;
+    for (int i = 0; i < count; ++i) {
+        Rental r;
+        snprintf(r.renterName, sizeof(r.renterName), "%s %d", names[i % 5], i);
+        strcpy(r.phoneModel, models[i % 3][0]);
+        strcpy(r.modelVariant, models[i % 3][1]);
+        string monthDay = string(i % 12 < 9 ? "0" : "") + to_string(i % 12 + 1) + (i % 28 < 9 ? "/0" : "/") + to_string(i % 28 + 1);
+        strcpy(r.startDate, (monthDay + "/2025").c_str());
+        strcpy(r.endDate, (monthDay + "/2026").c_str());
+        r.days = i % 400 + 1;
+        r.totalAmount = r.days * 2000;
+        records[i] = r;
+    }
+
+    auto bestOf3 = [](const function<bool()> &save) {
+        double best = 1e30;
+        for (int run = 0; run < 3; ++run) {
+            auto start = chrono::steady_clock::now();
+            if (!save()) return -1.0;
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    };
+    const string streamFile = "bench_save_streams.txt", bufferFile = "bench_save_buffered.txt";
+    double streamSeconds = bestOf3([&] {
+        ofstream file(streamFile);
+        for (const auto &entry : records) {
+            const Rental &r = entry.second;
+            file << r.renterName << "|" << r.phoneModel << "|" << r.modelVariant << "|"
+                 << r.startDate << "|" << r.endDate << "|" << r.days << "|" << r.totalAmount << "\n";
+        }
+        file.close();
+        return (bool)file;
+    });
+    string savedDataFile = dataFile, error;
+    dataFile = bufferFile;
+    double bufferSeconds = bestOf3([&] { return saveToFile(records, error); });
+    dataFile = savedDataFile;
+    if (streamSeconds < 0 || bufferSeconds < 0) {
+        cout << "Benchmark failed: could not write the scratch files\n";
+        return;
+    }
+
+    ifstream a(streamFile, ios::binary), b(bufferFile, ios::binary);
+    string streamBytes((istreambuf_iterator<char>(a)), istreambuf_iterator<char>());
+    string bufferBytes((istreambuf_iterator<char>(b)), istreambuf_iterator<char>());
+    a.close();
+    b.close();
+    bool sameRecords = bufferBytes.compare(0, streamBytes.size(), streamBytes) == 0
+                       && bufferBytes.compare(streamBytes.size(), 10, "#snapshot ") == 0;
+
+    // Changes keep coming while snapshots are written from the writer's own copy
+    BackgroundWriter<Rental> snapshotWriter;
+    dataFile = bufferFile;
+    unsigned long long firstGeneration = snapshotGeneration;
+    snapshotWriter.start(records, [this](const map<int, Rental> &saved, string &saveError) {
+        return saveToFile(saved, saveError);
+    });
+    const int changes = 2000;
+    double totalMicros = 0, worstMicros = 0;
+    for (int i = 0; i < changes; ++i) {
+        auto start = chrono::steady_clock::now();
+        if (i % 2 == 0) snapshotWriter.submitAdd(count + i, records.begin()->second);
+        else snapshotWriter.submitRemove(count + i - 1, records.begin()->second);
+        double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        totalMicros += micros;
+        worstMicros = max(worstMicros, micros);
+        this_thread::sleep_for(chrono::microseconds(500));
+    }
+    snapshotWriter.flush();
+    snapshotWriter.stop();
+    unsigned long long snapshots = snapshotGeneration - firstGeneration;
+    dataFile = savedDataFile;
+    for (const string &file : { streamFile, bufferFile, bufferFile + ".bak", bufferFile + ".tmp" }) remove(file.c_str());
+
+    double megabytes = streamBytes.size() / (1024.0 * 1024.0);
+    cout << "Saved " << count << " records (" << megabytes << " MB), best of 3\n";
+    cout << "  ofstream <<   : " << streamSeconds << " s, " << (long long)(count / streamSeconds) << " records/s, "
+         << megabytes / streamSeconds << " MB/s\n";
+    cout << "  saveToFile    : " << bufferSeconds << " s, " << (long long)(count / bufferSeconds) << " records/s, "
+         << megabytes / bufferSeconds << " MB/s (synced snapshot with checksum)\n";
+    cout << "  Speedup       : " << streamSeconds / bufferSeconds << "x, record lines "
+         << (sameRecords ? "identical" : "DIFFERENT") << "\n";
+    cout << changes << " changes submitted during " << snapshots << " snapshot(s): mean "
+         << totalMicros / changes << " us, worst " << worstMicros << " us per submit\n";
+}
+
+// Run the engine checks on seeded random data in a scratch directory and print one line per check.
+// Needs no data file and leaves nothing behind, so it is safe to run anywhere.
+int RentalServiceSystem::runSelfTest() {
+    filesystem::path scratch = filesystem::temp_directory_path()
+        / ("rental_selftest_" + to_string(chrono::steady_clock::now().time_since_epoch().count()));
+    error_code ec;
+    filesystem::create_directories(scratch, ec);
+    if (ec) {
+        cout << "Error: could not create " << scratch.string() << "\n";
+        return 1;
+    }
+    string report;
+    bool passed = selfTestSort((scratch / "sort_").string(), report);
+    passed = selfTestLsm((scratch / "names").string(), report) && passed;
+    passed = selfTestLz(report) && passed;
+    filesystem::remove_all(scratch, ec);
+    cout << report << (passed ? "All checks passed.\n" : "Some checks FAILED.\n");
+    return passed ? 0 : 1;
 }
 
 // Main function
-int main() {
+// Usage: program                                   (interactive menu)
+//        program --query "<q>"                     (run one query and exit)
+//        program --script <file|->                 (run protocol commands, one per line)
+//        program --loadtest <ops> <ops/s> [file]   (replay a synthetic or recorded workload; 0 ops/s = unthrottled)
+//        program --changes <offset-file> [batch]   (print changes since the saved offset and advance it)
+//        program --export <file> [keys]            (write all records sorted, default keys model,variant,start,name)
+//        program --lookup "<name>"                 (list a renter's rentals from the on-disk name store)
+//        program --bench-save <records>            (compare save throughput of iostreams and RecordWriter)
+//        program --selftest                        (check sorting, the name store and compression; exit 1 on failure)
+//        program --follow <host>:<port>            (replicate from a leader; read-only commands from stdin)
+// Any of these can be preceded by --memory <MB> to keep records and their indexes within about that
+// much memory; closed rentals beyond it move to rentals_archive.bin and are still found by every search.
+// The menu, --script and --loadtest can instead be preceded by --leader [<host>:]<port> to stream
+// every change to followers connecting on that port (loopback unless a host is given). Followers
+// and leader must share RENTAL_REPLICATION_SECRET when it is set, and it must be set for a host.
+int main(int argc, char *argv[]) {
     RentalServiceSystem rentalSystem; // Create an instance of the rental system class
-    rentalSystem.run();               // Run the rental system interface
-    return 0;                         // End of program
+    bool budgeted = false, leading = false;
+    while (argc >= 3 && (strcmp(argv[1], "--memory") == 0 || strcmp(argv[1], "--leader") == 0)) {
+        if (strcmp(argv[1], "--memory") == 0) {
+            rentalSystem.setMemoryBudget((size_t)(atof(argv[2]) * 1024 * 1024));
+            budgeted = true;
+        } else if (rentalSystem.setReplicationAddress(argv[2])) {
+            leading = true;
+        } else {
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    if (budgeted && leading) {
+        // Archived records live outside the data file that new followers are started from
+        cout << "--leader can't be combined with --memory: followers would miss archived rentals.\n";
+        return 1;
+    }
+    if (argc == 2 && strcmp(argv[1], "--selftest") == 0) {
+        return rentalSystem.runSelfTest();
+    }
+    if (argc == 3 && strcmp(argv[1], "--follow") == 0) {
+        return rentalSystem.runFollower(argv[2]);
+    }
+    if (argc == 3 && strcmp(argv[1], "--query") == 0) {
+        rentalSystem.runQuery(argv[2]);
+        return 0;
+    }
+    if (argc == 3 && strcmp(argv[1], "--script") == 0) {
+        return rentalSystem.runScript(argv[2]) == 0 ? 0 : 1;
+    }
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--export") == 0) {
+        return rentalSystem.runExport(argv[2], argc == 4 ? argv[3] : "") ? 0 : 1;
+    }
+    if (argc == 3 && strcmp(argv[1], "--bench-save") == 0) {
+        rentalSystem.runSaveBenchmark(atoi(argv[2]));
+        return 0;
+    }
+    if (argc == 3 && strcmp(argv[1], "--lookup") == 0) {
+        rentalSystem.runLookup(argv[2]);
+        return 0;
+    }
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--changes") == 0) {
+        rentalSystem.runChangeFeed(argv[2], argc == 4 ? atoi(argv[3]) : 100);
+        return 0;
+    }
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--loadtest") == 0) {
+        return rentalSystem.runLoadTest(atoi(argv[2]), atof(argv[3]), argc == 5 ? argv[4] : "") ? 0 : 1;
+    }
+    return rentalSystem.run();        // Run the rental system interface
 }
@@ -5,28 +5,18 @@ public:
     string phoneVariant;
     string startDate;
     string endDate;
-    double totalAmount;
+    long long totalCentavos; // Exact amount; 1 peso = 100 centavos
 
     bool isAlphabetic(const string& str) {
-        for (char c : str) {
-            if (!isalpha(c) && c != ' ') return false;
-        }
-        return true;
+        return validName(str);
     }
 
     bool isNumeric(const string& str) {
-        bool dotSeen = false;
-        for (char c : str) {
-            if (!isdigit(c)) {
-                if (c == '.' && !dotSeen) dotSeen = true;
-                else return false;
-            }
-        }
-        return !str.empty();
+        return validAmount(str);
     }
 
     void input();
     void display() const;
-    void writeToFile(ofstream &out) const;
+    void writeToFile(RecordWriter &out) const;
     bool readFromFile(ifstream &in);
 };
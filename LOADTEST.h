@@ -0,0 +1,88 @@
+// Load generator for the command protocol
+// Replays synthetic or recorded command lines at a target rate and reports throughput and latency.
+// Latency is measured from each command's scheduled send time, so a run that falls behind
+// shows the queueing delay instead of hiding it.
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <cstdio>
+
+// Build a synthetic counter workload: mostly adds and lookups, some queries and deletes
+inline vector<string> syntheticWorkload(int count, unsigned seed) {
+    static const char *firstNames[] = { "Ana", "Ben", "Carla", "Dan", "Ella", "Felix", "Gina", "Hugo", "Ivy", "Jose" };
+    static const char *lastNames[] = { "Cruz", "Reyes", "Santos", "Garcia", "Lim", "Tan", "Bautista", "Ramos" };
+    static const char *iphone[] = { "base", "pro", "pro max" };
+    static const char *samsung[] = { "base", "plus", "ultra" };
+
+    mt19937 rng(seed);
+    auto pick = [&](int n) { return (int)(rng() % n); };
+    auto date = [&](int month, int day) {
+        char buf[11];
+        snprintf(buf, sizeof(buf), "%02d/%02d/2025", month, day);
+        return string(buf);
+    };
+    auto name = [&]() { return string(firstNames[pick(10)]) + " " + lastNames[pick(8)]; };
+
+    vector<string> commands;
+    commands.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        int kind = pick(100);
+        if (kind < 40) {
+            bool apple = pick(2) == 0;
+            int month = 1 + pick(12), day = 1 + pick(20);
+            commands.push_back("ADD " + name() + "|" + (apple ? "iPhone 16" : "Samsung Galaxy S25") + "|"
+                               + (apple ? iphone[pick(3)] : samsung[pick(3)]) + "|"
+                               + date(month, day) + "|" + date(month, day + 1 + pick(8)));
+        } else if (kind < 70) {
+            commands.push_back("SEARCH " + name());
+        } else if (kind < 85) {
+            commands.push_back("QUERY name=" + name() + " AND amount>4000");
+        } else if (kind < 95) {
+            commands.push_back("DELETE " + name());
+        } else {
+            commands.push_back("NEXT 5");
+        }
+    }
+    return commands;
+}
+
+// Run commands at ratePerSecond (0 = as fast as possible) and print a throughput/latency report
+inline void runLoad(const vector<string> &commands, double ratePerSecond, const function<void(const string &)> &execute) {
+    typedef chrono::steady_clock Clock;
+    vector<double> latencies; // Microseconds
+    latencies.reserve(commands.size());
+
+    Clock::time_point begin = Clock::now();
+    for (size_t i = 0; i < commands.size(); ++i) {
+        Clock::time_point scheduled = begin;
+        if (ratePerSecond > 0) {
+            scheduled += chrono::duration_cast<Clock::duration>(chrono::duration<double>(i / ratePerSecond));
+            this_thread::sleep_until(scheduled);
+        } else {
+            scheduled = Clock::now();
+        }
+        execute(commands[i]);
+        latencies.push_back(chrono::duration<double, micro>(Clock::now() - scheduled).count());
+    }
+    double seconds = chrono::duration<double>(Clock::now() - begin).count();
+
+    if (latencies.empty()) {
+        printf("No commands to run.\n");
+        return;
+    }
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        size_t index = (size_t)(p / 100.0 * (latencies.size() - 1) + 0.5);
+        return latencies[index];
+    };
+    printf("Operations : %zu in %.3f s\n", latencies.size(), seconds);
+    printf("Throughput : %.0f ops/s (target %s)\n", latencies.size() / seconds,
+           ratePerSecond > 0 ? to_string((long long)ratePerSecond).c_str() : "unlimited");
+    printf("Latency us : p50 %.1f | p90 %.1f | p99 %.1f | p99.9 %.1f | max %.1f\n",
+           percentile(50), percentile(90), percentile(99), percentile(99.9), latencies.back());
+}
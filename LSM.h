@@ -0,0 +1,661 @@
+// LSM-style on-disk store keyed by renter name
+// Writes go to an in-memory memtable, which is flushed to immutable sorted segment files. Each
+// segment holds 4 KB blocks of sorted entries, a sparse index with the first key of every block,
+// and a Bloom filter over renter names. A background thread merges segments level by level:
+// L0 collects flushed segments, and every deeper level is a single sorted run about ten times the
+// size of the one above. A lookup costs one block read per segment whose Bloom filter says "maybe",
+// so usually one read, and a renter who doesn't exist usually costs none.
+//
+// Keys are "<name>\x01<rest>" and values are count deltas (+1 add, -1 delete). Deltas for the
+// same key are summed when segments merge, and keys that sum to zero are dropped.
+// Segment files are synced before the manifest that lists them. Uses syncFile from CHANGELOG.h.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+const uint32_t SEGMENT_MAGIC = 0x4C534D31; // "LSM1"
+const size_t SEGMENT_BLOCK_BYTES = 4096;
+
+// Part of a key the Bloom filter is built on (the renter name)
+inline string lsmNameOf(const string &key) {
+    return key.substr(0, key.find('\x01'));
+}
+
+// Two independent 64-bit hashes for Bloom filter double hashing
+inline void lsmHash(const string &s, uint64_t &h1, uint64_t &h2) {
+    h1 = 1469598103934665603ULL;
+    h2 = 0x9E3779B97F4A7C15ULL;
+    for (unsigned char c : s) {
+        h1 = (h1 ^ c) * 1099511628211ULL;
+        h2 = (h2 + c) * 0xC2B2AE3D27D4EB4FULL;
+        h2 ^= h2 >> 29;
+    }
+    h2 |= 1;
+}
+
+// Fixed-size trailer at the end of every segment file
+struct SegmentFooter {
+    uint64_t indexOffset;
+    uint64_t bloomOffset;
+    uint64_t entries;
+    uint32_t hashes;
+    uint32_t magic;
+};
+
+// Writes sorted (key, delta) entries into a segment file
+class SegmentWriter {
+private:
+    ofstream out;
+    string block;
+    string blockFirstKey;
+    uint64_t offset = 0;
+    vector<pair<string, pair<uint64_t, uint32_t>>> index; // First key -> (offset, length)
+    vector<uint64_t> nameHashes[2];
+    string lastName;
+    uint64_t entries = 0;
+
+    void endBlock() {
+        if (block.empty()) return;
+        out.write(block.data(), block.size());
+        index.push_back({ blockFirstKey, { offset, (uint32_t)block.size() } });
+        offset += block.size();
+        block.clear();
+    }
+
+public:
+    bool open(const string &path) {
+        out.open(path, ios::binary | ios::trunc);
+        return (bool)out;
+    }
+
+    // Keys must arrive in ascending order
+    void add(const string &key, int32_t delta) {
+        if (block.empty()) blockFirstKey = key;
+        uint16_t length = (uint16_t)key.size();
+        block.append((const char *)&length, sizeof(length));
+        block.append(key);
+        block.append((const char *)&delta, sizeof(delta));
+        ++entries;
+        string name = lsmNameOf(key);
+        if (name != lastName || entries == 1) {
+            uint64_t h1, h2;
+            lsmHash(name, h1, h2);
+            nameHashes[0].push_back(h1);
+            nameHashes[1].push_back(h2);
+            lastName = name;
+        }
+        if (block.size() >= SEGMENT_BLOCK_BYTES) endBlock();
+    }
+
+    // Write the index, Bloom filter and footer; returns false on I/O failure
+    bool finish() {
+        endBlock();
+        SegmentFooter footer;
+        footer.indexOffset = offset;
+        uint32_t count = (uint32_t)index.size();
+        out.write((const char *)&count, sizeof(count));
+        for (const auto &entry : index) {
+            uint16_t length = (uint16_t)entry.first.size();
+            out.write((const char *)&length, sizeof(length));
+            out.write(entry.first.data(), length);
+            out.write((const char *)&entry.second.first, sizeof(uint64_t));
+            out.write((const char *)&entry.second.second, sizeof(uint32_t));
+        }
+        footer.bloomOffset = out.tellp();
+
+        // About 10 bits per name and 7 probes: roughly a 1% false positive rate
+        uint64_t bits = max((uint64_t)64, (uint64_t)nameHashes[0].size() * 10);
+        vector<unsigned char> bloom((bits + 7) / 8, 0);
+        footer.hashes = 7;
+        for (size_t n = 0; n < nameHashes[0].size(); ++n) {
+            for (uint32_t k = 0; k < footer.hashes; ++k) {
+                uint64_t bit = (nameHashes[0][n] + k * nameHashes[1][n]) % bits;
+                bloom[bit / 8] |= 1 << (bit % 8);
+            }
+        }
+        out.write((const char *)&bits, sizeof(bits));
+        out.write((const char *)bloom.data(), bloom.size());
+
+        footer.entries = entries;
+        footer.magic = SEGMENT_MAGIC;
+        out.write((const char *)&footer, sizeof(footer));
+        out.close();
+        return (bool)out;
+    }
+};
+
+// An immutable segment: the sparse index and Bloom filter stay in memory, blocks are read on demand
+class Segment {
+private:
+    vector<string> firstKeys;
+    vector<pair<uint64_t, uint32_t>> blocks; // (offset, length)
+    vector<unsigned char> bloom;
+    uint64_t bloomBits = 0;
+    uint32_t hashes = 0;
+
+public:
+    string path;
+    uint64_t bytes = 0;
+    uint64_t entries = 0;
+    bool obsolete = false; // Set once merged away; the file is removed when the last reader lets go
+
+    ~Segment() {
+        if (obsolete) remove(path.c_str());
+    }
+
+    bool open(const string &file) {
+        path = file;
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        in.seekg(0, ios::end);
+        bytes = in.tellg();
+        if (bytes < sizeof(SegmentFooter)) return false;
+        SegmentFooter footer;
+        in.seekg(bytes - sizeof(footer));
+        in.read((char *)&footer, sizeof(footer));
+        if (!in || footer.magic != SEGMENT_MAGIC) return false;
+        entries = footer.entries;
+        hashes = footer.hashes;
+
+        in.seekg(footer.indexOffset);
+        uint32_t count = 0;
+        in.read((char *)&count, sizeof(count));
+        for (uint32_t i = 0; i < count && in; ++i) {
+            uint16_t length;
+            in.read((char *)&length, sizeof(length));
+            string key(length, '\0');
+            in.read(&key[0], length);
+            uint64_t offset;
+            uint32_t size;
+            in.read((char *)&offset, sizeof(offset));
+            in.read((char *)&size, sizeof(size));
+            firstKeys.push_back(key);
+            blocks.push_back({ offset, size });
+        }
+        in.read((char *)&bloomBits, sizeof(bloomBits));
+        bloom.resize((bloomBits + 7) / 8);
+        in.read((char *)bloom.data(), bloom.size());
+        return (bool)in && bloomBits > 0;
+    }
+
+    // False means the name is definitely not in this segment
+    bool mayContain(const string &name) const {
+        uint64_t h1, h2;
+        lsmHash(name, h1, h2);
+        for (uint32_t k = 0; k < hashes; ++k) {
+            uint64_t bit = (h1 + k * h2) % bloomBits;
+            if (!(bloom[bit / 8] & (1 << (bit % 8)))) return false;
+        }
+        return true;
+    }
+
+    size_t blockCount() const { return blocks.size(); }
+
+    // Read and decode one block
+    bool readBlock(ifstream &in, size_t b, vector<pair<string, int32_t>> &out) const {
+        string data(blocks[b].second, '\0');
+        in.seekg(blocks[b].first);
+        if (!in.read(&data[0], data.size())) return false;
+        size_t pos = 0;
+        while (pos + sizeof(uint16_t) <= data.size()) {
+            uint16_t length;
+            memcpy(&length, &data[pos], sizeof(length));
+            pos += sizeof(length);
+            string key = data.substr(pos, length);
+            pos += length;
+            int32_t delta;
+            memcpy(&delta, &data[pos], sizeof(delta));
+            pos += sizeof(delta);
+            out.push_back({ key, delta });
+        }
+        return true;
+    }
+
+    // Add the deltas of every key starting with prefix to totals; counts block reads
+    void scan(const string &prefix, map<string, long long> &totals, int &reads) const {
+        if (blocks.empty() || !mayContain(lsmNameOf(prefix))) return;
+        // The prefix can only start in the last block whose first key is not after it
+        size_t b = upper_bound(firstKeys.begin(), firstKeys.end(), prefix) - firstKeys.begin();
+        b = b == 0 ? 0 : b - 1;
+        ifstream in(path, ios::binary);
+        for (; b < blocks.size(); ++b) {
+            vector<pair<string, int32_t>> entries;
+            if (!readBlock(in, b, entries)) return;
+            ++reads;
+            bool pastPrefix = false;
+            for (const auto &entry : entries) {
+                if (entry.first.compare(0, prefix.size(), prefix) == 0) totals[entry.first] += entry.second;
+                else if (entry.first > prefix) { pastPrefix = true; break; }
+            }
+            if (pastPrefix) break;
+        }
+    }
+};
+
+// The store: memtable, levels of segments and the background merge thread
+class LsmStore {
+private:
+    string dir;
+    mutex lock;                               // Guards memtable, levels and the manifest
+    map<string, long long> memtable;
+    vector<vector<shared_ptr<Segment>>> levels; // levels[0] newest last; deeper levels hold one run
+    unsigned long long appliedSeq = 0;        // Last change log sequence reflected on disk
+    unsigned long long savedSeq = 0;          // appliedSeq as of the last manifest that reached the disk
+    unsigned long long memtableSeq = 0;       // Last sequence applied to the memtable
+    unsigned long long nextFile = 1;
+    size_t memtableLimit = 4096;
+    bool opened = false;
+    bool readOnly = false;                    // Reader in another process: never writes or merges
+    thread merger;
+    condition_variable mergeWanted;
+    bool stopping = false;
+    string lastError;                         // Latest merge or open problem, until taken (guarded by lock)
+
+    static const size_t L0_LIMIT = 4;                 // Flushed segments before merging into L1
+    static const uint64_t L1_BYTES = 4 * 1024 * 1024; // L1 size that triggers merging down a level
+
+    string newSegmentPath() {
+        char name[40];
+        snprintf(name, sizeof(name), "/segment_%08llu.sst", nextFile++);
+        return dir + name;
+    }
+
+    // Rewrite the manifest (caller holds lock); written to a temp file, synced and renamed into place
+    bool saveManifest() {
+        string temp = dir + "/MANIFEST.tmp";
+        {
+            ofstream out(temp);
+            out << "applied " << appliedSeq << "\n" << "next " << nextFile << "\n";
+            for (size_t level = 0; level < levels.size(); ++level) {
+                for (const auto &segment : levels[level]) {
+                    out << "segment " << level << " " << filesystem::path(segment->path).filename().string() << "\n";
+                }
+            }
+            out.close();
+            if (!out || !syncFile(temp)) return false;
+        }
+        error_code ec;
+        filesystem::rename(temp, dir + "/MANIFEST", ec);
+        if (!ec) savedSeq = appliedSeq;
+        return !ec;
+    }
+
+    // Write sorted entries out as a synced segment file; the partial file is removed on failure
+    shared_ptr<Segment> writeSegment(const string &path, const function<bool(SegmentWriter &)> &fill) {
+        SegmentWriter writer;
+        shared_ptr<Segment> segment(new Segment());
+        if (!writer.open(path) || !fill(writer) || !writer.finish() || !syncFile(path) || !segment->open(path)) {
+            remove(path.c_str());
+            return nullptr;
+        }
+        return segment;
+    }
+
+    // Merge segments (oldest first) into one sorted run, summing deltas and dropping zero totals.
+    // Returns null, leaving no file behind, if an input can't be read or the output can't be written.
+    shared_ptr<Segment> mergeSegments(const vector<shared_ptr<Segment>> &inputs, string path) {
+        struct Cursor {
+            shared_ptr<Segment> segment;
+            ifstream in;
+            size_t block = 0;
+            vector<pair<string, int32_t>> entries;
+            size_t pos = 0;
+            bool failed = false;
+            bool next() {
+                while (pos >= entries.size()) {
+                    if (failed || block >= segment->blockCount()) return false;
+                    entries.clear();
+                    pos = 0;
+                    if (!segment->readBlock(in, block++, entries)) failed = true;
+                }
+                return true;
+            }
+        };
+        vector<unique_ptr<Cursor>> cursors;
+        for (const auto &segment : inputs) {
+            unique_ptr<Cursor> cursor(new Cursor());
+            cursor->segment = segment;
+            cursor->in.open(segment->path, ios::binary);
+            cursors.push_back(move(cursor));
+        }
+
+        return writeSegment(path, [&](SegmentWriter &writer) {
+            while (true) {
+                const string *smallest = nullptr;
+                for (auto &cursor : cursors) {
+                    if (cursor->next() && (!smallest || cursor->entries[cursor->pos].first < *smallest)) {
+                        smallest = &cursor->entries[cursor->pos].first;
+                    }
+                }
+                if (!smallest) break;
+                string key = *smallest;
+                long long total = 0;
+                for (auto &cursor : cursors) {
+                    if (cursor->next() && cursor->entries[cursor->pos].first == key) {
+                        total += cursor->entries[cursor->pos].second;
+                        ++cursor->pos;
+                    }
+                }
+                if (total != 0) writer.add(key, (int32_t)total);
+            }
+            for (auto &cursor : cursors) {
+                if (cursor->failed) return false;
+            }
+            return true;
+        });
+    }
+
+    // Pick one merge that is due, or return false (caller holds lock)
+    bool pickMerge(size_t &level, vector<shared_ptr<Segment>> &inputs) {
+        if (levels[0].size() >= L0_LIMIT) {
+            level = 0;
+        } else {
+            level = levels.size();
+            uint64_t limit = L1_BYTES;
+            for (size_t l = 1; l < levels.size(); ++l, limit *= 10) {
+                if (!levels[l].empty() && levels[l][0]->bytes > limit) { level = l; break; }
+            }
+            if (level == levels.size()) return false;
+        }
+        if (levels.size() <= level + 1) levels.resize(level + 2);
+        inputs.clear();
+        for (const auto &segment : levels[level + 1]) inputs.push_back(segment); // Older data first
+        for (const auto &segment : levels[level]) inputs.push_back(segment);
+        return true;
+    }
+
+    // Background thread: run merges whenever one is due. A failed merge is reported through
+    // takeError and tried again a few seconds later; lookups still work without it.
+    void mergeLoop() {
+        unique_lock<mutex> lk(lock);
+        while (true) {
+            size_t level;
+            vector<shared_ptr<Segment>> inputs;
+            if (!pickMerge(level, inputs)) {
+                if (stopping) return;
+                mergeWanted.wait(lk);
+                continue;
+            }
+            size_t fromLevel = levels[level].size();
+            string path = newSegmentPath();
+            lk.unlock();
+            shared_ptr<Segment> merged = mergeSegments(inputs, path);
+            lk.lock();
+            if (!merged) {
+                lastError = "merging " + to_string(inputs.size()) + " segments in " + dir + " failed";
+                if (stopping) return;
+                mergeWanted.wait_for(lk, chrono::seconds(5));
+                continue;
+            }
+            // Segments flushed into L0 while merging stay; only the merged inputs go
+            levels[level].erase(levels[level].begin(), levels[level].begin() + fromLevel);
+            levels[level + 1].assign(1, merged);
+            // Inputs the manifest on disk still lists are kept until a newer manifest is saved
+            if (saveManifest()) {
+                for (auto &segment : inputs) segment->obsolete = true;
+            } else {
+                lastError = "could not save the manifest in " + dir;
+            }
+        }
+    }
+
+    // Write the memtable out as a new L0 segment (caller holds lock)
+    bool flushLocked() {
+        if (memtable.empty()) {
+            appliedSeq = memtableSeq;
+            saveManifest();
+            return true;
+        }
+        shared_ptr<Segment> segment = writeSegment(newSegmentPath(), [&](SegmentWriter &writer) {
+            for (const auto &entry : memtable) {
+                if (entry.second != 0) writer.add(entry.first, (int32_t)entry.second);
+            }
+            return true;
+        });
+        if (!segment) return false; // The memtable is kept and written with the next flush
+        levels[0].push_back(segment);
+        memtable.clear();
+        appliedSeq = memtableSeq;
+        mergeWanted.notify_one();
+        return saveManifest();
+    }
+
+    // Forget a store whose manifest lists a segment that can't be read, so it is built again from
+    // the records; its deltas can't be recovered from the change log alone
+    void discardDamaged(const string &file) {
+        lastError = "name store segment " + file + " could not be read, so the store is being rebuilt";
+        levels.assign(1, vector<shared_ptr<Segment>>());
+        appliedSeq = 0;
+        nextFile = 1;
+        if (readOnly) return;
+        error_code ec;
+        for (const auto &entry : filesystem::directory_iterator(dir, ec)) {
+            string name = entry.path().filename().string();
+            if (name.compare(0, 8, "segment_") == 0 || name.compare(0, 8, "MANIFEST") == 0) filesystem::remove(entry.path(), ec);
+        }
+    }
+
+public:
+    ~LsmStore() { close(); }
+
+    // Open the store in a directory; returns false if it has to be built from the records: it had
+    // no manifest yet, or a segment the manifest lists is unreadable (see takeError). A writable
+    // store then starts empty; a read-only one keeps later adds in its memtable and leaves the files alone.
+    bool open(const string &directory, bool readOnlyStore = false) {
+        dir = directory;
+        readOnly = readOnlyStore;
+        appliedSeq = 0;
+        nextFile = 1;
+        levels.assign(1, vector<shared_ptr<Segment>>());
+        error_code ec;
+        filesystem::create_directories(dir, ec);
+        bool existed = false;
+        string damaged;
+        ifstream manifest(dir + "/MANIFEST");
+        string word;
+        while (manifest >> word) {
+            existed = true;
+            if (word == "applied") manifest >> appliedSeq;
+            else if (word == "next") manifest >> nextFile;
+            else if (word == "segment") {
+                size_t level;
+                string file;
+                manifest >> level >> file;
+                shared_ptr<Segment> segment(new Segment());
+                if (!segment->open(dir + "/" + file)) {
+                    damaged = file;
+                    break;
+                }
+                if (levels.size() <= level) levels.resize(level + 1);
+                levels[level].push_back(segment);
+            }
+        }
+        manifest.close();
+        if (!damaged.empty()) {
+            discardDamaged(damaged);
+            existed = false;
+        }
+        memtableSeq = appliedSeq;
+        savedSeq = appliedSeq;
+        stopping = false;
+        opened = true;
+        if (!readOnly) merger = thread(&LsmStore::mergeLoop, this);
+        return existed;
+    }
+
+    bool isOpen() const { return opened; }
+
+    // Return and clear the most recent merge or open problem, or "" if none
+    string takeError() {
+        lock_guard<mutex> lk(lock);
+        string error = lastError;
+        lastError.clear();
+        return error;
+    }
+
+    // Last change log sequence reflected in the store, including the memtable
+    unsigned long long appliedSequence() {
+        lock_guard<mutex> lk(lock);
+        return memtableSeq;
+    }
+
+    // Last change log sequence the files on disk reflect; a restart replays from the one after it
+    unsigned long long savedSequence() {
+        lock_guard<mutex> lk(lock);
+        return opened && !readOnly ? savedSeq : 0;
+    }
+
+    // Add a delta for a key as of change log sequence seq
+    void add(const string &key, int delta, unsigned long long seq) {
+        lock_guard<mutex> lk(lock);
+        memtable[key] += delta;
+        if (seq > memtableSeq) memtableSeq = seq;
+        if (memtable.size() >= memtableLimit && !readOnly) flushLocked();
+    }
+
+    // Flush the memtable to disk
+    bool flush() {
+        lock_guard<mutex> lk(lock);
+        return !readOnly && flushLocked();
+    }
+
+    // Keys starting with prefix and their summed counts (only positive ones), plus block reads used
+    vector<pair<string, long long>> scanPrefix(const string &prefix, int &reads) {
+        map<string, long long> totals;
+        vector<shared_ptr<Segment>> segments;
+        {
+            lock_guard<mutex> lk(lock);
+            for (auto it = memtable.lower_bound(prefix); it != memtable.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+                totals[it->first] += it->second;
+            }
+            for (const auto &level : levels) segments.insert(segments.end(), level.begin(), level.end());
+        }
+        reads = 0;
+        for (const auto &segment : segments) segment->scan(prefix, totals, reads);
+        vector<pair<string, long long>> result;
+        for (const auto &entry : totals) {
+            if (entry.second > 0) result.push_back(entry);
+        }
+        return result;
+    }
+
+    // Flush and stop the merge thread; the store can be opened again afterwards
+    void close() {
+        if (!opened) return;
+        if (merger.joinable()) {
+            {
+                lock_guard<mutex> lk(lock);
+                flushLocked();
+                stopping = true;
+            }
+            mergeWanted.notify_one();
+            merger.join();
+        }
+        opened = false;
+        memtable.clear();
+        levels.clear();
+    }
+};
+
+// Check the store against an in-memory map on seeded random +1/-1 deltas, adding a PASS/FAIL line
+// per check to report. Enough keys are written that memtable flushes and L0 merges fold deltas
+// for the same key across segments. dir must not hold a store yet; it is left for the caller.
+inline bool selfTestLsm(const string &dir, string &report) {
+    mt19937 rng(20250602);
+    bool passed = true;
+    auto check = [&](const string &what, bool ok) {
+        report += (ok ? "PASS " : "FAIL ") + what + "\n";
+        if (!ok) passed = false;
+    };
+    const int names = 400, rests = 60;
+    auto nameOf = [](int n) { return "renter " + to_string(n); };
+    map<string, long long> expected;
+    // Every name's scan matches the positive totals in expected
+    auto sameAsExpected = [&](LsmStore &store, int &reads) {
+        reads = 0;
+        bool same = true;
+        for (int n = 0; n < names; ++n) {
+            string prefix = nameOf(n) + '\x01';
+            vector<pair<string, long long>> want;
+            for (auto it = expected.lower_bound(prefix); it != expected.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+                if (it->second > 0) want.push_back(*it);
+            }
+            int scanReads = 0;
+            same = same && store.scanPrefix(prefix, scanReads) == want;
+            reads += scanReads;
+        }
+        return same;
+    };
+
+    LsmStore store;
+    check("LSM opens an empty directory as a fresh store", !store.open(dir));
+    unsigned long long seq = 0;
+    bool sameWhileMerging = true;
+    int reads;
+    for (int op = 0; op < 150000; ++op) {
+        string key = nameOf(rng() % names) + '\x01' + "r" + to_string(rng() % rests);
+        int delta = expected[key] > 0 && rng() % 3 == 0 ? -1 : 1;
+        expected[key] += delta;
+        store.add(key, delta, ++seq);
+        if (op % 7000 == 6999) store.flush();
+        if (op % 50000 == 49999) sameWhileMerging = sameWhileMerging && sameAsExpected(store, reads);
+    }
+    check("LSM scans match while segments are flushed and merged", sameWhileMerging);
+    check("LSM scans match after 150000 deltas", sameAsExpected(store, reads));
+
+    int missReads = 0;
+    bool nothingFound = true;
+    for (int n = 0; n < 200; ++n) {
+        int lookupReads = 0;
+        nothingFound = nothingFound && store.scanPrefix("absent " + to_string(n) + '\x01', lookupReads).empty();
+        missReads += lookupReads;
+    }
+    check("LSM Bloom filters skip most segments for absent names (" + to_string(missReads) + " block reads for 200 lookups)",
+          nothingFound && missReads < 20);
+    store.close();
+
+    // Merges left pending are finished on close, so L0 is under its limit and deeper levels exist
+    ifstream manifest(dir + "/MANIFEST");
+    string word;
+    size_t level, levelZero = 0, deeper = 0;
+    while (manifest >> word) {
+        if (word != "segment") continue;
+        string file;
+        manifest >> level >> file;
+        ++(level == 0 ? levelZero : deeper);
+    }
+    check("LSM merges keep L0 small (" + to_string(levelZero) + " L0, " + to_string(deeper) + " deeper segments)",
+          levelZero < 4 && deeper > 0);
+
+    bool existed = store.open(dir);
+    check("LSM reopens with every delta applied", existed && store.appliedSequence() == seq);
+    check("LSM scans match after reopening", sameAsExpected(store, reads));
+    store.close();
+
+    // A segment the manifest lists but that can't be read makes the store start over
+    for (const auto &entry : filesystem::directory_iterator(dir)) {
+        if (entry.path().filename().string().compare(0, 8, "segment_") != 0) continue;
+        ofstream(entry.path().string(), ios::trunc) << "damaged";
+        break;
+    }
+    existed = store.open(dir);
+    int emptyReads = 0;
+    check("LSM asks for a rebuild when a listed segment is damaged",
+          !existed && !store.takeError().empty() && store.scanPrefix(nameOf(0) + '\x01', emptyReads).empty());
+    store.close();
+    return passed;
+}
@@ -7,6 +7,8 @@
 // Using the standard namespace to avoid prefixing std::
 using namespace std;
 
+#include "VALIDATE.h" // Shared name and date validation
+
 // Structure to hold rental information
 // All string variables are now character arrays (C-style strings)
 struct Rental {
@@ -30,15 +32,7 @@ void getName(char name[]) {
         cout << "Enter Renter Name (letters and spaces only): ";
         getline(cin, tempName); // Read the full line into std::string
 
-        bool valid = !tempName.empty(); // Check if input is not empty
-        for (char c : tempName) {
-            if (!isalpha(c) && c != ' ') { // Check if characters are letters or spaces
-                valid = false;
-                break;
-            }
-        }
-
-        if (valid) {
+        if (validName(tempName)) { // Not empty, letters and spaces only
             // Copy the content from std::string to char array
             // strncpy is used to prevent buffer overflow, copying at most size-1 characters
             strncpy(name, tempName.c_str(), sizeof(Rental::renterName) - 1);
@@ -99,8 +93,8 @@ void getDate(char date[], const string &prompt) {
     while (true) {
         cout << prompt;
         getline(cin, tempDate); // Read date into std::string
-        // Check for MM/DD/YYYY format: length 10, slashes at index 2 and 5
-        if (tempDate.length() == 10 && tempDate[2] == '/' && tempDate[5] == '/') {
+        // Check for MM/DD/YYYY format with a month and day that exist
+        if (validDate(tempDate)) {
             // Copy from std::string to char array
             strncpy(date, tempDate.c_str(), sizeof(Rental::startDate) - 1); // Using startDate size as both are 11
             date[sizeof(Rental::startDate) - 1] = '\0';
@@ -145,6 +139,7 @@ void loadFromFile() {
     }
     string line;
     while (getline(file, line)) { // Read each line into a std::string
+        if (line.empty() || line[0] == '#') continue; // Skip the snapshot checksum line
         Rental r;
         size_t pos = 0;
         // Iterate through the fields separated by '|'
@@ -0,0 +1,167 @@
+// Query language for rental records
+// Example: model=iPhone 16 AND variant=pro max AND start>=01/01/2025 AND amount>10000 SORT amount DESC LIMIT 10
+// Keywords (AND, SORT, ASC, DESC, LIMIT) are upper case so they never clash with values like "Sandy".
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// Fields a predicate or sort can refer to
+enum QueryField { Q_NAME, Q_MODEL, Q_VARIANT, Q_START, Q_END, Q_DAYS, Q_AMOUNT };
+
+// Comparison operators
+enum QueryOp { Q_EQ, Q_NE, Q_LT, Q_LE, Q_GT, Q_GE };
+
+// One "field op value" condition
+struct Predicate {
+    QueryField field;
+    QueryOp op;
+    string text;  // Value for name, model and variant
+    int number;   // Value for start/end (epoch day), days and amount
+};
+
+// Parsed query: predicates joined by AND, optional sort and limit
+struct Query {
+    vector<Predicate> predicates;
+    bool sorted = false;
+    QueryField sortField = Q_NAME;
+    bool descending = false;
+    int limit = -1; // -1 means no limit
+};
+
+// Convert an MM/DD/YYYY date to days since 01/01/1970, or -1 if it can't be read
+inline int toEpochDay(const char date[]) {
+    int m, d, y;
+    if (sscanf(date, "%d/%d/%d", &m, &d, &y) != 3 || m < 1 || m > 12 || d < 1 || d > 31) return -1;
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// True for fields that hold text rather than numbers
+inline bool isTextField(QueryField f) {
+    return f == Q_NAME || f == Q_MODEL || f == Q_VARIANT;
+}
+
+// Remove leading and trailing spaces
+inline string trimSpaces(const string &s) {
+    size_t b = s.find_first_not_of(' ');
+    if (b == string::npos) return "";
+    size_t e = s.find_last_not_of(' ');
+    return s.substr(b, e - b + 1);
+}
+
+// Map a field name to its enum value
+inline bool parseField(const string &name, QueryField &field) {
+    static const char *names[] = { "name", "model", "variant", "start", "end", "days", "amount" };
+    for (int i = 0; i < 7; ++i) {
+        if (name == names[i]) {
+            field = (QueryField)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parse one "field op value" clause
+inline bool parsePredicate(const string &clause, Predicate &p, string &error) {
+    size_t opPos = clause.find_first_of("=!<>");
+    if (opPos == string::npos) {
+        error = "Missing operator in \"" + clause + "\"";
+        return false;
+    }
+    if (!parseField(trimSpaces(clause.substr(0, opPos)), p.field)) {
+        error = "Unknown field in \"" + clause + "\"";
+        return false;
+    }
+
+    size_t opLen = (opPos + 1 < clause.size() && clause[opPos + 1] == '=') ? 2 : 1;
+    string op = clause.substr(opPos, opLen);
+    if (op == "=" || op == "==") p.op = Q_EQ;
+    else if (op == "!=") p.op = Q_NE;
+    else if (op == "<") p.op = Q_LT;
+    else if (op == "<=") p.op = Q_LE;
+    else if (op == ">") p.op = Q_GT;
+    else if (op == ">=") p.op = Q_GE;
+    else {
+        error = "Unknown operator \"" + op + "\"";
+        return false;
+    }
+
+    p.text = trimSpaces(clause.substr(opPos + opLen));
+    p.number = 0;
+    if (p.text.empty()) {
+        error = "Missing value in \"" + clause + "\"";
+        return false;
+    }
+    if (p.field == Q_START || p.field == Q_END) {
+        p.number = toEpochDay(p.text.c_str());
+        if (p.number < 0) {
+            error = "Invalid date \"" + p.text + "\", use MM/DD/YYYY";
+            return false;
+        }
+    } else if (!isTextField(p.field)) {
+        try {
+            p.number = stoi(p.text);
+        } catch (...) {
+            error = "Invalid number \"" + p.text + "\"";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parse a whole query string
+inline bool parseQuery(const string &text, Query &q, string &error) {
+    string rest = " " + text + " ";
+
+    // LIMIT must come last and be a plain non-negative number, so nothing after it is lost
+    size_t limitPos = rest.find(" LIMIT ");
+    if (limitPos != string::npos) {
+        string count = trimSpaces(rest.substr(limitPos + 7));
+        if (count.empty() || count.size() > 9 || count.find_first_not_of("0123456789") != string::npos) {
+            error = "LIMIT needs a non-negative number and must be the last clause";
+            return false;
+        }
+        q.limit = stoi(count);
+        rest = rest.substr(0, limitPos + 1);
+    }
+
+    size_t sortPos = rest.find(" SORT ");
+    if (sortPos != string::npos) {
+        string sortSpec = trimSpaces(rest.substr(sortPos + 6));
+        rest = rest.substr(0, sortPos + 1);
+        size_t space = sortSpec.find(' ');
+        string direction = space == string::npos ? "" : trimSpaces(sortSpec.substr(space));
+        if (!parseField(sortSpec.substr(0, space), q.sortField)) {
+            error = "Unknown sort field \"" + sortSpec + "\"";
+            return false;
+        }
+        if (direction == "DESC") q.descending = true;
+        else if (!direction.empty() && direction != "ASC") {
+            error = "Sort direction must be ASC or DESC";
+            return false;
+        }
+        q.sorted = true;
+    }
+
+    size_t pos = 0;
+    while (pos < rest.size()) {
+        size_t next = rest.find(" AND ", pos);
+        string clause = trimSpaces(rest.substr(pos, next == string::npos ? string::npos : next - pos));
+        if (!clause.empty()) {
+            Predicate p;
+            if (!parsePredicate(clause, p, error)) return false;
+            q.predicates.push_back(p);
+        } else if (next != string::npos) {
+            error = "Empty condition next to AND";
+            return false;
+        }
+        if (next == string::npos) break;
+        pos = next + 5;
+    }
+    return true;
+}
@@ -0,0 +1,584 @@
+// Leader/follower replication over TCP, built on the change log
+// A follower connects, proves it knows the shared secret, and says which sequence number it has
+// applied up to (0 for none). The leader
+// answers a new follower, or one whose position has left the change log, with a snapshot of its
+// records, then streams change log events from the follower's position on. Events go in batches of up to 1024, each LZ-compressed inside one frame.
+// When there is nothing new, the leader sends an empty frame every 100 ms, so followers always
+// know how far behind they are. A follower that loses its leader reconnects and resumes where it
+// stopped. The leader listens on loopback unless told otherwise. The secret keeps strangers from
+// reading the records, but nothing is encrypted, so use a tunnel across networks you don't trust.
+// Record must be trivially copyable (see CHANGELOG.h).
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <list>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+inline void closeSocket(SocketHandle s) { closesocket(s); }
+inline void shutdownSocket(SocketHandle s) { shutdown(s, SD_BOTH); }
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+typedef int SocketHandle;
+const SocketHandle NO_SOCKET = -1;
+inline void closeSocket(SocketHandle s) { ::close(s); }
+inline void shutdownSocket(SocketHandle s) { shutdown(s, SHUT_RDWR); }
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Start the socket library once (only needed on Windows)
+inline void socketsReady() {
+#ifdef _WIN32
+    static bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    (void)started;
+#endif
+}
+
+// Send or receive exactly n bytes; false if the connection broke
+inline bool sendAll(SocketHandle s, const char *data, size_t n) {
+    while (n > 0) {
+        int sent = send(s, data, (int)n, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        data += sent;
+        n -= sent;
+    }
+    return true;
+}
+inline bool recvAll(SocketHandle s, char *data, size_t n) {
+    while (n > 0) {
+        int got = recv(s, data, (int)n, 0);
+        if (got <= 0) return false;
+        data += got;
+        n -= got;
+    }
+    return true;
+}
+
+// Connect to host:port; NO_SOCKET on failure
+inline SocketHandle connectTo(const string &host, int port) {
+    socketsReady();
+    addrinfo hints = {}, *found = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &found) != 0) return NO_SOCKET;
+    SocketHandle s = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (s != NO_SOCKET && connect(s, found->ai_addr, (int)found->ai_addrlen) != 0) {
+        closeSocket(s);
+        s = NO_SOCKET;
+    }
+    freeaddrinfo(found);
+    if (s != NO_SOCKET) {
+        int on = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+    }
+    return s;
+}
+
+// Listen on a port of one local IPv4 address ("127.0.0.1" for loopback only); NO_SOCKET on failure
+inline SocketHandle listenOn(const string &host, int port) {
+    socketsReady();
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) return NO_SOCKET;
+    SocketHandle s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == NO_SOCKET) return NO_SOCKET;
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+    if (::bind(s, (sockaddr *)&address, sizeof(address)) != 0 || listen(s, 16) != 0) {
+        closeSocket(s);
+        return NO_SOCKET;
+    }
+    return s;
+}
+
+// Byte-oriented LZ77. A control byte below 0x80 starts a run of ctl + 1 literal bytes. A control
+// byte of 0x80 or more is a match of (ctl & 0x7F) + 4 bytes, followed by a 16-bit back offset.
+// Fixed-size records are mostly zero padding and repeated model names, so batches shrink well.
+inline string lzCompress(const string &in) {
+    string out;
+    out.reserve(in.size() / 2 + 16);
+    vector<int> table(1 << 14, -1); // Hash of 4 bytes -> last position seen
+    size_t literalStart = 0, i = 0;
+    auto flushLiterals = [&](size_t end) {
+        while (literalStart < end) {
+            size_t run = min((size_t)128, end - literalStart);
+            out += (char)(run - 1);
+            out.append(in, literalStart, run);
+            literalStart += run;
+        }
+    };
+    while (i + 4 <= in.size()) {
+        uint32_t word;
+        memcpy(&word, in.data() + i, 4);
+        uint32_t hash = (word * 2654435761u) >> 18;
+        int candidate = table[hash];
+        table[hash] = (int)i;
+        if (candidate >= 0 && i - candidate <= 0xFFFF && memcmp(in.data() + candidate, in.data() + i, 4) == 0) {
+            size_t length = 4;
+            while (length < 131 && i + length < in.size() && in[candidate + length] == in[i + length]) ++length;
+            flushLiterals(i);
+            uint16_t offset = (uint16_t)(i - candidate);
+            out += (char)(0x80 | (length - 4));
+            out.append((const char *)&offset, 2);
+            i += length;
+            literalStart = i;
+        } else {
+            ++i;
+        }
+    }
+    flushLiterals(in.size());
+    return out;
+}
+
+// Undo lzCompress; false if the input is damaged or doesn't expand to rawSize bytes
+inline bool lzDecompress(const char *in, size_t n, size_t rawSize, string &out) {
+    out.clear();
+    out.reserve(rawSize);
+    size_t i = 0;
+    while (i < n) {
+        unsigned char ctl = (unsigned char)in[i++];
+        if (ctl < 0x80) {
+            size_t run = ctl + 1;
+            if (i + run > n) return false;
+            out.append(in + i, run);
+            i += run;
+        } else {
+            if (i + 2 > n) return false;
+            uint16_t offset;
+            memcpy(&offset, in + i, 2);
+            i += 2;
+            size_t length = (ctl & 0x7F) + 4;
+            if (offset == 0 || offset > out.size()) return false;
+            size_t from = out.size() - offset;
+            for (size_t k = 0; k < length; ++k) out += out[from + k]; // May overlap what it appends
+        }
+        if (out.size() > rawSize) return false;
+    }
+    return out.size() == rawSize;
+}
+
+// Check that lzCompress output expands back to its input, and that lzDecompress rejects truncated
+// or mis-sized frames and never grows damaged ones past rawSize. Adds a PASS/FAIL line per check.
+inline bool selfTestLz(string &report) {
+    mt19937 rng(20250603);
+    bool passed = true;
+    auto check = [&](const string &what, bool ok) {
+        report += (ok ? "PASS " : "FAIL ") + what + "\n";
+        if (!ok) passed = false;
+    };
+
+    // 64-byte slots with a name and mostly zero padding, like a batch of change events
+    const char *names[] = { "Ana Cruz", "Juan Dela Cruz", "Maria Santos", "iPhone 16", "Samsung Galaxy S25" };
+    string records(64 * 4000, '\0');
+    for (size_t slot = 0; slot < 4000; ++slot) {
+        string name = string(names[rng() % 5]) + " " + to_string(rng() % 100);
+        records.replace(slot * 64, name.size(), name);
+    }
+    string noise(100000, '\0');
+    for (char &c : noise) c = (char)rng();
+    // Repeats just inside and just past the farthest offset a match can reach
+    string nearFar = noise.substr(0, 1000) + string(64535, 'x') + noise.substr(0, 1000);
+    string tooFar = noise.substr(0, 1000) + string(64537, 'x') + noise.substr(0, 1000);
+    vector<pair<string, string>> inputs = { { "empty", "" }, { "1 byte", "a" }, { "3 bytes", "abc" },
+        { "1 MB of zeros", string(1 << 20, '\0') }, { "random bytes", noise }, { "record slots", records },
+        { "match at the offset limit", nearFar }, { "repeat past the offset limit", tooFar } };
+    for (const auto &input : inputs) {
+        string packed = lzCompress(input.second), unpacked;
+        bool ok = lzDecompress(packed.data(), packed.size(), input.second.size(), unpacked) && unpacked == input.second;
+        check("LZ round trip, " + input.first + " (" + to_string(input.second.size()) + " -> " + to_string(packed.size()) + " bytes)", ok);
+    }
+    check("LZ shrinks record slots at least 4x", lzCompress(records).size() * 4 <= records.size());
+
+    string packed = lzCompress(records), unpacked;
+    bool rejected = !lzDecompress(packed.data(), packed.size(), records.size() - 1, unpacked)
+        && !lzDecompress(packed.data(), packed.size(), records.size() + 1, unpacked);
+    check("LZ rejects a frame whose raw size is wrong", rejected);
+    rejected = true;
+    for (size_t cut = 0; cut < packed.size(); cut += 1 + cut / 64) {
+        rejected = rejected && !lzDecompress(packed.data(), cut, records.size(), unpacked);
+    }
+    check("LZ rejects every truncated frame", rejected);
+    bool bounded = true;
+    for (int trial = 0; trial < 2000; ++trial) {
+        string damaged = packed;
+        damaged[rng() % damaged.size()] ^= (char)(1 + rng() % 255);
+        if (lzDecompress(damaged.data(), damaged.size(), records.size(), unpacked)) bounded = bounded && unpacked.size() == records.size();
+        else bounded = bounded && unpacked.size() <= records.size() + 131;
+    }
+    check("LZ keeps damaged frames within rawSize", bounded);
+    return passed;
+}
+
+const uint32_t REPLICATION_MAGIC = 0x52504C31; // "RPL1"
+enum FrameKind { FRAME_SNAPSHOT = 1, FRAME_CHANGES = 2 };
+
+// First thing a follower sends: the shared secret, then the sequence it has applied up to
+struct ReplicationHello {
+    uint32_t magic;
+    uint32_t secretBytes;  // Secret bytes that follow
+};
+const uint32_t MAX_SECRET_BYTES = 256;
+
+// Shared secret both sides read from RENTAL_REPLICATION_SECRET ("" if it isn't set)
+inline string replicationSecret() {
+    const char *value = getenv("RENTAL_REPLICATION_SECRET");
+    return value ? value : "";
+}
+
+// Compare secrets without stopping at the first difference, so timing doesn't leak a prefix
+inline bool sameSecret(const string &a, const string &b) {
+    unsigned char diff = a.size() != b.size();
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i) diff |= (unsigned char)(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+// Sent in front of every batch
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t kind;
+    uint32_t count;        // Events in the batch (0 for a heartbeat)
+    uint32_t rawBytes;     // Events as ChangeHeader + Record, before compression
+    uint32_t packedBytes;  // Bytes that follow
+    uint32_t reserved;
+    uint64_t lastSeq;      // Sequence the follower has once this batch is applied
+    uint64_t leaderSeq;    // Newest sequence the leader had when sending
+    int64_t sentMicros;    // Leader's wall clock when sending
+};
+
+inline int64_t wallMicros() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Leader side: accepts followers and streams the change log to each on its own thread
+template <typename Record>
+class ReplicationLeader {
+public:
+    // Fills records with a consistent snapshot and returns the last sequence it includes
+    typedef function<unsigned long long(vector<Record> &)> SnapshotFunction;
+
+private:
+    // One connected follower; socket and finished are guarded by followersMutex
+    struct Connection {
+        SocketHandle socket = NO_SOCKET;
+        thread worker;
+        bool finished = false; // serve() returned and the socket is closed
+    };
+
+    string prefix;
+    string secret;
+    SnapshotFunction snapshot;
+    SocketHandle listener = NO_SOCKET;
+    thread acceptor;
+    mutex followersMutex;
+    list<Connection> followers;
+    atomic<bool> stopping;
+    atomic<unsigned long long> newestSeq; // Newest sequence appended to the change log
+
+    // Compress a batch of events and send it as one frame
+    bool sendFrame(SocketHandle s, FrameKind kind, const string &raw, uint32_t count, unsigned long long lastSeq) {
+        string packed = raw.empty() ? string() : lzCompress(raw);
+        FrameHeader header = { REPLICATION_MAGIC, (uint32_t)kind, count, (uint32_t)raw.size(), (uint32_t)packed.size(), 0,
+                               lastSeq, max(newestSeq.load(), lastSeq), wallMicros() };
+        return sendAll(s, (const char *)&header, sizeof(header)) && sendAll(s, packed.data(), packed.size());
+    }
+
+    static void appendEvent(string &raw, ChangeType type, unsigned long long seq, int id, const Record &record) {
+        ChangeHeader header = { CHANGE_MAGIC, (uint32_t)type, seq, id, (uint32_t)sizeof(Record) };
+        raw.append((const char *)&header, sizeof(header));
+        raw.append((const char *)&record, sizeof(Record));
+    }
+
+    // One follower: check its secret, send a snapshot if it has nothing, then the change log from its position on
+    void serve(SocketHandle s) {
+        ReplicationHello hello;
+        if (!recvAll(s, (char *)&hello, sizeof(hello)) || hello.magic != REPLICATION_MAGIC || hello.secretBytes > MAX_SECRET_BYTES) return;
+        string offered(hello.secretBytes, '\0');
+        if (hello.secretBytes > 0 && !recvAll(s, &offered[0], offered.size())) return;
+        if (!sameSecret(offered, secret)) return;
+        uint64_t applied = 0;
+        if (!recvAll(s, (char *)&applied, sizeof(applied))) return;
+        // A follower whose next change was already removed from the log starts over from a snapshot
+        if (applied + 1 < firstChangeSequence(prefix)) applied = 0;
+
+        string raw;
+        if (applied == 0) {
+            vector<Record> records;
+            applied = snapshot(records);
+            for (size_t i = 0; i == 0 || i < records.size(); i += 1024) { // Always one frame, so the follower resets
+                raw.clear();
+                size_t end = min(records.size(), i + 1024);
+                for (size_t r = i; r < end; ++r) appendEvent(raw, CHANGE_ADD, applied, (int)r, records[r]);
+                if (!sendFrame(s, FRAME_SNAPSHOT, raw, (uint32_t)(end - i), applied)) return;
+            }
+        }
+
+        ChangeCursor<Record> cursor(prefix, applied + 1);
+        vector<ChangeEvent<Record>> batch;
+        auto lastSend = chrono::steady_clock::now();
+        while (!stopping.load()) {
+            batch.clear();
+            if (cursor.read(batch, 1024) > 0) {
+                raw.clear();
+                for (const ChangeEvent<Record> &e : batch) appendEvent(raw, e.type, e.seq, e.id, e.record);
+                if (!sendFrame(s, FRAME_CHANGES, raw, (uint32_t)batch.size(), batch.back().seq)) return;
+                lastSend = chrono::steady_clock::now();
+                continue;
+            }
+            if (chrono::steady_clock::now() - lastSend > chrono::milliseconds(100)) {
+                if (!sendFrame(s, FRAME_CHANGES, string(), 0, cursor.position() - 1)) return;
+                lastSend = chrono::steady_clock::now();
+            }
+            this_thread::sleep_for(chrono::milliseconds(2)); // New events show up once per writer burst
+        }
+    }
+
+    // Serve one follower, then close its socket and mark it for reaping
+    void serveAndClose(Connection *connection) {
+        serve(connection->socket);
+        lock_guard<mutex> lk(followersMutex);
+        closeSocket(connection->socket);
+        connection->socket = NO_SOCKET;
+        connection->finished = true;
+    }
+
+    // Join and forget followers that have disconnected; caller holds followersMutex
+    void reapFinished() {
+        for (auto it = followers.begin(); it != followers.end();) {
+            if (!it->finished) {
+                ++it;
+                continue;
+            }
+            it->worker.join();
+            it = followers.erase(it);
+        }
+    }
+
+    void acceptLoop() {
+        while (!stopping.load()) {
+            fd_set ready;
+            FD_ZERO(&ready);
+            FD_SET(listener, &ready);
+            timeval wait = { 0, 200000 }; // Wake up regularly to notice stop() and reap followers
+            int found = select((int)listener + 1, &ready, nullptr, nullptr, &wait);
+            lock_guard<mutex> lk(followersMutex);
+            reapFinished();
+            if (found <= 0) continue;
+            SocketHandle s = accept(listener, nullptr, nullptr);
+            if (s == NO_SOCKET) continue;
+            int on = 1;
+            setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+            followers.emplace_back();
+            Connection &connection = followers.back();
+            connection.socket = s;
+            connection.worker = thread(&ReplicationLeader::serveAndClose, this, &connection);
+        }
+    }
+
+public:
+    ReplicationLeader() : stopping(false), newestSeq(0) {}
+    ~ReplicationLeader() { stop(); }
+
+    // Listen for followers on host:port who send this secret; returns false if the port can't be opened
+    bool start(const string &host, int port, const string &sharedSecret, const string &changeLogPrefix, SnapshotFunction snapshotFunction) {
+        prefix = changeLogPrefix;
+        secret = sharedSecret;
+        snapshot = snapshotFunction;
+        listener = listenOn(host, port);
+        if (listener == NO_SOCKET) return false;
+        acceptor = thread(&ReplicationLeader::acceptLoop, this);
+        return true;
+    }
+
+    // Called as events are appended, so heartbeats can report how far ahead the leader is
+    void noteSequence(unsigned long long seq) { newestSeq.store(seq); }
+
+    // Disconnect every follower and stop listening
+    void stop() {
+        if (!acceptor.joinable()) return;
+        stopping.store(true);
+        acceptor.join();
+        closeSocket(listener);
+        list<Connection> ending;
+        {
+            lock_guard<mutex> lk(followersMutex);
+            for (Connection &connection : followers) {
+                if (connection.socket != NO_SOCKET) shutdownSocket(connection.socket);
+            }
+            ending.splice(ending.end(), followers);
+        }
+        for (Connection &connection : ending) connection.worker.join(); // Each closes its own socket
+    }
+};
+
+// Replication counters a follower keeps, for the LAG report
+struct ReplicationStats {
+    unsigned long long appliedSeq = 0;
+    unsigned long long leaderSeq = 0;
+    unsigned long long events = 0;
+    unsigned long long batches = 0;
+    unsigned long long rawBytes = 0;
+    unsigned long long wireBytes = 0;      // Every frame, heartbeats included
+    unsigned long long eventWireBytes = 0; // Frames that carried events, for the compression ratio
+    double lastDelayMs = 0;   // Leader send -> batch applied, for the newest batch with events
+    double maxDelayMs = 0;
+    double catchUpSeconds = -1; // Connect -> first time fully caught up (-1 until then)
+    unsigned long long catchUpEvents = 0;
+    bool connected = false;
+};
+
+// Follower side: receives batches on its own thread and hands their events to apply()
+template <typename Record>
+class ReplicationFollower {
+public:
+    typedef function<void(const vector<ChangeEvent<Record>> &)> ApplyFunction;
+    // Drops every replicated record before a fresh snapshot comes in
+    typedef function<void()> ResetFunction;
+
+private:
+    string host;
+    int port = 0;
+    string secret;
+    ApplyFunction apply;
+    ResetFunction reset;
+    thread worker;
+    atomic<bool> stopping;
+    atomic<SocketHandle> current;
+    mutex statsMutex;
+    ReplicationStats stats;
+
+    // Receive frames until the connection drops; returns false on a protocol error
+    bool receive(SocketHandle s) {
+        auto connected = chrono::steady_clock::now();
+        bool snapshotStarted = false;
+        string packed, raw;
+        vector<ChangeEvent<Record>> events;
+        FrameHeader header;
+        while (recvAll(s, (char *)&header, sizeof(header))) {
+            if (header.magic != REPLICATION_MAGIC) return false;
+            packed.resize(header.packedBytes);
+            if (header.packedBytes > 0 && !recvAll(s, &packed[0], packed.size())) break;
+            if (header.rawBytes > 0 && !lzDecompress(packed.data(), packed.size(), header.rawBytes, raw)) return false;
+
+            if (header.kind == FRAME_SNAPSHOT && !snapshotStarted) {
+                // A snapshot replaces everything, including a partial one cut off by a disconnect
+                snapshotStarted = true;
+                reset();
+                lock_guard<mutex> lk(statsMutex);
+                stats.appliedSeq = 0;
+            }
+            events.clear();
+            for (size_t pos = 0; header.count > 0 && pos + sizeof(ChangeHeader) + sizeof(Record) <= raw.size();
+                 pos += sizeof(ChangeHeader) + sizeof(Record)) {
+                ChangeHeader h;
+                memcpy(&h, raw.data() + pos, sizeof(h));
+                ChangeEvent<Record> e;
+                e.seq = h.seq;
+                e.type = (ChangeType)h.type;
+                e.id = h.id;
+                memcpy(&e.record, raw.data() + pos + sizeof(h), sizeof(Record));
+                events.push_back(e);
+            }
+            if (!events.empty()) apply(events);
+
+            lock_guard<mutex> lk(statsMutex);
+            // A snapshot is only complete once its last batch is in, so it stays "behind" until then
+            if (header.kind == FRAME_CHANGES) stats.appliedSeq = header.lastSeq;
+            stats.leaderSeq = header.leaderSeq;
+            stats.batches += header.count > 0;
+            stats.events += header.count;
+            stats.rawBytes += header.rawBytes;
+            stats.wireBytes += sizeof(header) + header.packedBytes;
+            if (header.count > 0) stats.eventWireBytes += sizeof(header) + header.packedBytes;
+            if (header.count > 0) {
+                stats.lastDelayMs = (wallMicros() - header.sentMicros) / 1000.0;
+                stats.maxDelayMs = max(stats.maxDelayMs, stats.lastDelayMs);
+            }
+            if (stats.catchUpSeconds < 0 && header.kind == FRAME_CHANGES && stats.appliedSeq >= stats.leaderSeq) {
+                stats.catchUpSeconds = chrono::duration<double>(chrono::steady_clock::now() - connected).count();
+                stats.catchUpEvents = stats.events;
+            }
+        }
+        return true;
+    }
+
+    // Connect, receive, and reconnect from the applied position whenever the leader goes away
+    void loop() {
+        while (!stopping.load()) {
+            SocketHandle s = connectTo(host, port);
+            if (s == NO_SOCKET) {
+                this_thread::sleep_for(chrono::milliseconds(500));
+                continue;
+            }
+            uint64_t from;
+            {
+                lock_guard<mutex> lk(statsMutex);
+                from = stats.appliedSeq;
+                stats.connected = true;
+            }
+            current.store(s);
+            ReplicationHello hello = { REPLICATION_MAGIC, (uint32_t)secret.size() };
+            bool ok = sendAll(s, (const char *)&hello, sizeof(hello)) && sendAll(s, secret.data(), secret.size())
+                      && sendAll(s, (const char *)&from, sizeof(from)) && receive(s);
+            current.store(NO_SOCKET);
+            closeSocket(s);
+            {
+                lock_guard<mutex> lk(statsMutex);
+                stats.connected = false;
+            }
+            if (!ok) break;
+            if (!stopping.load()) this_thread::sleep_for(chrono::milliseconds(500));
+        }
+    }
+
+public:
+    ReplicationFollower() : stopping(false), current(NO_SOCKET) {}
+    ~ReplicationFollower() { stop(); }
+
+    // Follow the leader at host:port on a background thread
+    void start(const string &leaderHost, int leaderPort, const string &sharedSecret, ApplyFunction applyFunction, ResetFunction resetFunction) {
+        host = leaderHost;
+        port = leaderPort;
+        secret = sharedSecret.substr(0, MAX_SECRET_BYTES);
+        apply = applyFunction;
+        reset = resetFunction;
+        worker = thread(&ReplicationFollower::loop, this);
+    }
+
+    ReplicationStats snapshotStats() {
+        lock_guard<mutex> lk(statsMutex);
+        return stats;
+    }
+
+    void stop() {
+        if (!worker.joinable()) return;
+        stopping.store(true);
+        SocketHandle s = current.load();
+        if (s != NO_SOCKET) shutdownSocket(s);
+        worker.join();
+    }
+};
@@ -0,0 +1,164 @@
+// Due-date scheduler: an indexed min-heap of record IDs ordered by end date (epoch day)
+// insert/remove are O(log n), peek is O(1), and listing the k earliest entries is O(k log k)
+// ReturnSchedule splits rentals into upcoming and past-due heaps, so due-today and next-returns
+// lookups never walk the rental history. Each rental moves to the past-due heap once.
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <ctime>
+#include <limits>
+
+// Today's local date as days since 01/01/1970
+inline int todayEpochDay() {
+    time_t now = time(nullptr);
+    tm local = *localtime(&now);
+    char date[11];
+    strftime(date, sizeof(date), "%m/%d/%Y", &local);
+    return toEpochDay(date);
+}
+
+class DueScheduler {
+private:
+    vector<pair<int, int>> heap;      // (end day, record ID), smallest end day at the top
+    unordered_map<int, size_t> slot;  // Record ID -> position in heap
+
+    // Place an entry at a position and remember where it went
+    void place(size_t i, const pair<int, int> &entry) {
+        heap[i] = entry;
+        slot[entry.second] = i;
+    }
+
+    // Move the entry at i up until its parent is not later
+    void siftUp(size_t i) {
+        pair<int, int> entry = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (heap[parent] <= entry) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+
+    // Move the entry at i down until neither child is earlier
+    void siftDown(size_t i) {
+        pair<int, int> entry = heap[i];
+        size_t n = heap.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && heap[child + 1] < heap[child]) ++child;
+            if (entry <= heap[child]) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, entry);
+    }
+
+public:
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+
+    // Earliest (end day, record ID); only valid when not empty
+    const pair<int, int> &peek() const { return heap.front(); }
+
+    // Schedule a record, or reschedule it if it is already present
+    void insert(int id, int endDay) {
+        auto it = slot.find(id);
+        if (it != slot.end()) {
+            size_t i = it->second;
+            heap[i].first = endDay;
+            siftUp(i);
+            siftDown(slot[id]);
+            return;
+        }
+        heap.push_back({ endDay, id });
+        siftUp(heap.size() - 1);
+    }
+
+    // Unschedule a record; does nothing if it isn't present
+    void remove(int id) {
+        auto it = slot.find(id);
+        if (it == slot.end()) return;
+        size_t i = it->second;
+        slot.erase(it);
+        pair<int, int> last = heap.back();
+        heap.pop_back();
+        if (i == heap.size()) return;
+        place(i, last);
+        siftUp(i);
+        siftDown(slot[last.second]);
+    }
+
+    // Entries in end-day order while end day <= maxDay, at most limit of them.
+    // Walks the heap best-first with a small frontier heap, so it only touches
+    // the k returned entries and their children instead of the whole heap.
+    vector<pair<int, int>> earliest(int maxDay, size_t limit) const {
+        vector<pair<int, int>> result;
+        vector<pair<pair<int, int>, size_t>> frontier; // (entry, heap position)
+        auto later = [](const pair<pair<int, int>, size_t> &a, const pair<pair<int, int>, size_t> &b) {
+            return a.first > b.first;
+        };
+        if (!heap.empty()) frontier.push_back({ heap[0], 0 });
+        while (!frontier.empty() && result.size() < limit) {
+            pop_heap(frontier.begin(), frontier.end(), later);
+            auto top = frontier.back();
+            frontier.pop_back();
+            if (top.first.first > maxDay) break;
+            result.push_back(top.first);
+            for (size_t child = 2 * top.second + 1; child <= 2 * top.second + 2 && child < heap.size(); ++child) {
+                frontier.push_back({ heap[child], child });
+                push_heap(frontier.begin(), frontier.end(), later);
+            }
+        }
+        return result;
+    }
+};
+
+// Rentals split by whether their end date has passed. Upcoming rentals (end day >= today) are in
+// one heap and overdue ones in another. advanceTo moves entries across as the date changes, which
+// costs O(log n) per rental over its whole lifetime, so due today and the next k returns cost
+// O(k log k) however many past rentals there are.
+class ReturnSchedule {
+private:
+    DueScheduler upcoming; // End day >= today
+    DueScheduler past;     // End day < today, most overdue at the top
+    int today = numeric_limits<int>::min(); // Day the split was last made for
+
+public:
+    size_t size() const { return upcoming.size() + past.size(); }
+    size_t overdueCount() const { return past.size(); }
+
+    // Schedule a record, or reschedule it if it is already present
+    void insert(int id, int endDay) {
+        upcoming.remove(id);
+        past.remove(id);
+        if (endDay < today) past.insert(id, endDay);
+        else upcoming.insert(id, endDay);
+    }
+
+    // Unschedule a record; does nothing if it isn't present
+    void remove(int id) {
+        upcoming.remove(id);
+        past.remove(id);
+    }
+
+    // Move rentals that ended before day into the overdue heap
+    void advanceTo(int day) {
+        if (day <= today) return;
+        today = day;
+        while (!upcoming.empty() && upcoming.peek().first < today) {
+            pair<int, int> entry = upcoming.peek();
+            upcoming.remove(entry.second);
+            past.insert(entry.second, entry.first);
+        }
+    }
+
+    // Upcoming rentals in end-day order while end day <= maxDay, at most limit of them
+    vector<pair<int, int>> upcomingUntil(int maxDay, size_t limit) const { return upcoming.earliest(maxDay, limit); }
+
+    // Overdue rentals, most overdue first
+    vector<pair<int, int>> overdue() const { return past.earliest(numeric_limits<int>::max(), past.size()); }
+};
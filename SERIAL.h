@@ -0,0 +1,165 @@
+// Buffered record serializer for the save path
+// Fields are formatted with to_chars straight into one reusable buffer, and the buffer goes to the
+// file in large fwrite calls. No locale or iostream is involved, and once the buffer exists a save
+// allocates nothing. Money is kept as exact integer centavos and written as "1234.50".
+// A CRC-32 of everything written is kept as the buffer drains, for snapshot checksums.
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>     // _commit
+#else
+#include <unistd.h> // fsync
+#endif
+
+// CRC-32 (IEEE), eight bytes per step with slicing tables built on first use
+inline uint32_t crc32Update(uint32_t crc, const char *data, size_t n) {
+    static const vector<uint32_t> table = [] {
+        vector<uint32_t> t(8 * 256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int slice = 1; slice < 8; ++slice) t[slice * 256 + i] = (t[(slice - 1) * 256 + i] >> 8) ^ t[t[(slice - 1) * 256 + i] & 0xFF];
+        }
+        return t;
+    }();
+    const uint32_t *t = table.data();
+    const unsigned char *p = (const unsigned char *)data;
+    crc = ~crc;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint32_t low = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+        crc = t[7 * 256 + (low & 0xFF)] ^ t[6 * 256 + ((low >> 8) & 0xFF)] ^ t[5 * 256 + ((low >> 16) & 0xFF)]
+            ^ t[4 * 256 + (low >> 24)] ^ t[3 * 256 + p[4]] ^ t[2 * 256 + p[5]] ^ t[256 + p[6]] ^ t[p[7]];
+    }
+    while (n-- > 0) crc = t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+class RecordWriter {
+private:
+    vector<char> buffer;
+    size_t used = 0;
+    FILE *file = nullptr;
+    bool failed = false;
+    uint32_t crc = 0;
+
+    // Hand the buffered bytes to the file
+    void drain() {
+        crc = crc32Update(crc, buffer.data(), used);
+        if (used > 0 && fwrite(buffer.data(), 1, used, file) != used) failed = true;
+        used = 0;
+    }
+
+    // Room for n more bytes; only a field longer than the whole buffer makes it grow
+    char *reserve(size_t n) {
+        if (used + n > buffer.size()) {
+            drain();
+            if (n > buffer.size()) buffer.resize(n);
+        }
+        return buffer.data() + used;
+    }
+
+public:
+    explicit RecordWriter(size_t capacity = 1 << 20) : buffer(capacity) {}
+    ~RecordWriter() { close(); }
+
+    // Start writing a file from scratch; returns false if it can't be created
+    bool open(const string &path) {
+        close();
+        used = 0;
+        crc = 0;
+        file = fopen(path.c_str(), "wb");
+        failed = file == nullptr;
+        if (file) setvbuf(file, nullptr, _IONBF, 0); // The buffer above is the only one needed
+        return !failed;
+    }
+
+    void text(const char *s, size_t n) {
+        memcpy(reserve(n), s, n);
+        used += n;
+    }
+    void text(const char *s) { text(s, strlen(s)); }
+    void text(const string &s) { text(s.data(), s.size()); }
+
+    void put(char c) {
+        *reserve(1) = c;
+        ++used;
+    }
+
+    void number(long long value) {
+        char *p = reserve(20);
+        used = to_chars(p, p + 20, value).ptr - buffer.data();
+    }
+
+    // Centavos as pesos with exactly two decimals
+    void centavos(long long value) {
+        if (value < 0) {
+            put('-');
+            value = -value;
+        }
+        number(value / 100);
+        char *p = reserve(3);
+        p[0] = '.';
+        p[1] = (char)('0' + value % 100 / 10);
+        p[2] = (char)('0' + value % 10);
+        used += 3;
+    }
+
+    // CRC-32 of everything written since open
+    uint32_t checksum() {
+        drain();
+        return crc;
+    }
+
+    // Write out what is left and close the file; false if any write failed.
+    // With durable set, the data is also synced to the disk before closing.
+    bool close(bool durable = false) {
+        if (!file) return !failed;
+        drain();
+        if (durable) {
+            if (fflush(file) != 0) failed = true;
+#ifdef _WIN32
+            if (_commit(_fileno(file)) != 0) failed = true;
+#else
+            if (fsync(fileno(file)) != 0) failed = true;
+#endif
+        }
+        if (fclose(file) != 0) failed = true;
+        file = nullptr;
+        return !failed;
+    }
+};
+
+// Centavos as pesos with exactly two decimals, for display
+inline string formatCentavos(long long value) {
+    string text = to_string(value < 0 ? -value : value);
+    while (text.size() < 3) text.insert(text.begin(), '0');
+    text.insert(text.end() - 2, '.');
+    return value < 0 ? "-" + text : text;
+}
+
+// Parse "1234", "1234.5" or "1234.50" into exact centavos; false for anything else
+inline bool parseCentavos(const string &text, long long &value) {
+    size_t dot = text.find('.');
+    string whole = text.substr(0, dot);
+    string fraction = dot == string::npos ? "" : text.substr(dot + 1);
+    if (whole.empty() || whole.size() > 15 || fraction.size() > 2) return false;
+    long long pesos = 0;
+    auto parsed = from_chars(whole.data(), whole.data() + whole.size(), pesos);
+    if (parsed.ec != errc() || parsed.ptr != whole.data() + whole.size() || whole[0] == '-') return false;
+    long long cents = 0;
+    for (size_t i = 0; i < 2; ++i) {
+        char c = i < fraction.size() ? fraction[i] : '0';
+        if (c < '0' || c > '9') return false;
+        cents = cents * 10 + (c - '0');
+    }
+    value = pesos * 100 + cents;
+    return true;
+}
@@ -0,0 +1,154 @@
+// Crash-consistent snapshots of the data file
+// A snapshot is written in full to <file>.tmp, ending with the trailer line
+// "#snapshot <generation> <records> <crc32> <change seq>". The CRC covers every byte before the
+// trailer, and the change seq is the last change log event the snapshot includes. Once the
+// temp file is synced, the current file is hard-linked as <file>.bak and the temp file is renamed
+// over it, so <file> always exists for readers. On startup <file> is used as it is whenever it
+// checks out or has no trailer at all (an older save, another version of the program or a hand
+// edit). Only a missing <file>, or one failing its checksum, is replaced by the newest intact
+// <file>.tmp or <file>.bak. The file is never truncated in place.
+// Uses crc32Update from SERIAL.h.
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#ifndef _WIN32
+#include <fcntl.h>  // open, for syncing the directory
+#include <unistd.h> // fsync
+#endif
+
+// What the trailer of a snapshot file says
+struct SnapshotInfo {
+    string path;
+    unsigned long long generation = 0;
+    unsigned long long records = 0;
+    uint32_t crc = 0;
+    long long bodyBytes = 0;  // Bytes covered by the checksum
+    bool hasTrailer = false;  // False for files written before snapshots had trailers
+};
+
+// Trailer line for a snapshot body
+inline string snapshotTrailer(unsigned long long generation, unsigned long long records, uint32_t crc, unsigned long long changeSeq) {
+    char line[96];
+    snprintf(line, sizeof(line), "#snapshot %llu %llu %08x %llu\n", generation, records, (unsigned)crc, changeSeq);
+    return line;
+}
+
+// Read a file's trailer, if it has one; false if the file can't be opened
+inline bool readSnapshotTrailer(const string &path, SnapshotInfo &info) {
+    info = SnapshotInfo();
+    info.path = path;
+    error_code ec;
+    if (!filesystem::is_regular_file(path, ec)) return false;
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+    in.seekg(0, ios::end);
+    long long size = in.tellg();
+    long long tailBytes = size < 96 ? size : 96;
+    string tail(tailBytes, '\0');
+    in.seekg(size - tailBytes);
+    in.read(&tail[0], tailBytes);
+    size_t start = tail.rfind("#snapshot ");
+    if (start == string::npos || tail.back() != '\n' || (start > 0 && tail[start - 1] != '\n')) {
+        info.bodyBytes = size;
+        return true;
+    }
+    unsigned crc;
+    if (sscanf(tail.c_str() + start, "#snapshot %llu %llu %x", &info.generation, &info.records, &crc) == 3) {
+        info.crc = crc;
+        info.hasTrailer = true;
+        info.bodyBytes = size - (tailBytes - start);
+    }
+    return true;
+}
+
+// Check a snapshot's body against its trailer checksum
+inline bool verifySnapshot(const SnapshotInfo &info) {
+    if (!info.hasTrailer) return false;
+    ifstream in(info.path, ios::binary);
+    vector<char> chunk(1 << 20);
+    uint32_t crc = 0;
+    long long left = info.bodyBytes;
+    while (left > 0 && in) {
+        in.read(chunk.data(), left < (long long)chunk.size() ? left : chunk.size());
+        crc = crc32Update(crc, chunk.data(), in.gcount());
+        left -= in.gcount();
+    }
+    return left == 0 && crc == info.crc;
+}
+
+// Make a finished rename survive a power cut (no-op where directories can't be synced)
+inline void syncDirectoryOf(const string &path) {
+#ifndef _WIN32
+    filesystem::path parent = filesystem::path(path).parent_path();
+    int fd = ::open(parent.empty() ? "." : parent.string().c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#endif
+}
+
+// Put a synced temp snapshot in place, keeping the previous one as <path>.bak.
+// The rename replaces <path> in one step, so there is no moment without a data file.
+inline bool commitSnapshot(const string &path, string &error) {
+    error_code ec;
+    if (filesystem::exists(path, ec)) {
+        filesystem::remove(path + ".bak", ec);
+        filesystem::create_hard_link(path, path + ".bak", ec);
+        if (ec) {
+            // No hard links on this file system; a copy keeps the same guarantee, only slower
+            ec.clear();
+            filesystem::copy_file(path, path + ".bak", filesystem::copy_options::overwrite_existing, ec);
+        }
+        if (ec) {
+            error = "could not keep the previous " + path + " (" + ec.message() + ")";
+            return false;
+        }
+    }
+    filesystem::rename(path + ".tmp", path, ec);
+    if (ec) {
+        error = "could not rename the new snapshot into " + path + " (" + ec.message() + ")";
+        return false;
+    }
+    syncDirectoryOf(path);
+    return true;
+}
+
+// Make sure <path> holds the data to load. An intact <path>, or one with no trailer, is kept.
+// Otherwise the newest intact <path>.tmp or <path>.bak is moved to <path>.
+// Returns the generation in use (0 if none) and describes any recovery in note.
+inline unsigned long long recoverSnapshot(const string &path, string &note) {
+    note.clear();
+    SnapshotInfo current;
+    bool exists = readSnapshotTrailer(path, current);
+    if (exists && !current.hasTrailer) return 0;
+    if (exists && verifySnapshot(current)) return current.generation;
+
+    const SnapshotInfo *best = nullptr;
+    vector<SnapshotInfo> candidates;
+    for (const string &file : { path + ".tmp", path + ".bak" }) {
+        SnapshotInfo info;
+        if (readSnapshotTrailer(file, info)) candidates.push_back(info);
+    }
+    for (const SnapshotInfo &info : candidates) {
+        if ((!best || info.generation > best->generation) && verifySnapshot(info)) best = &info;
+    }
+    if (!best) {
+        // Nothing checks out, so a damaged <path> is loaded as far as it is readable
+        if (exists) note = "no snapshot of " + path + " passed its checksum; loading what is readable";
+        return 0;
+    }
+    error_code ec;
+    filesystem::rename(best->path, path, ec);
+    if (ec) {
+        note = "could not restore " + best->path + " (" + ec.message() + ")";
+        return 0;
+    }
+    syncDirectoryOf(path);
+    note = "recovered snapshot " + to_string(best->generation) + " from " + best->path;
+    return best->generation;
+}
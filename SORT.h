@@ -0,0 +1,255 @@
+// Sort engine for large multi-key exports
+// Records are never moved: every routine sorts a permutation of row numbers.
+// Text keys are dictionary-encoded by MSD radix sorting their distinct values on bytes, which turns
+// every key into a fixed-width 32-bit column. The columns are then LSD radix sorted, least
+// significant key first, with each byte pass split across threads. Byte positions that are the
+// same in every row are skipped. Exports too large for memory are cut into runs that are sorted
+// this way, and the runs are then merged.
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
+#include <queue>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <cstdint>
+#include <cstdio>
+
+// Run body(t) for t = 0..threads-1, one thread each (the caller's thread runs t = 0)
+inline void parallelFor(int threads, const function<void(int)> &body) {
+    vector<thread> workers;
+    for (int t = 1; t < threads; ++t) workers.emplace_back(body, t);
+    body(0);
+    for (thread &w : workers) w.join();
+}
+
+// Sort order[0..n) by values[order[i]] starting at byte depth, MSD radix with a 257-way split
+// (bucket 0 holds strings that end at this depth). Small groups fall back to comparison sort.
+inline void msdRadixSort(int *order, int *scratch, size_t n, size_t depth, const vector<string> &values) {
+    if (n < 32) {
+        sort(order, order + n, [&](int a, int b) {
+            return values[a].compare(depth, string::npos, values[b], depth, string::npos) < 0;
+        });
+        return;
+    }
+    size_t counts[258] = { 0 };
+    auto bucketOf = [&](int row) {
+        const string &s = values[row];
+        return depth < s.size() ? (unsigned char)s[depth] + 1 : 0;
+    };
+    for (size_t i = 0; i < n; ++i) ++counts[bucketOf(order[i]) + 1];
+    for (int b = 0; b < 257; ++b) counts[b + 1] += counts[b];
+    size_t starts[258];
+    copy(counts, counts + 258, starts);
+    for (size_t i = 0; i < n; ++i) scratch[counts[bucketOf(order[i])]++] = order[i];
+    copy(scratch, scratch + n, order);
+    for (int b = 1; b < 257; ++b) {
+        size_t size = starts[b + 1] - starts[b];
+        if (size > 1) msdRadixSort(order + starts[b], scratch + starts[b], size, depth + 1, values);
+    }
+}
+
+// Sort row numbers of values by byte order; the first split is done here and its buckets are
+// shared out to threads
+inline vector<int> sortStrings(const vector<string> &values, int threads) {
+    size_t n = values.size();
+    vector<int> order(n), scratch(n);
+    for (size_t i = 0; i < n; ++i) order[(size_t)i] = (int)i;
+    if (n < 2) return order;
+
+    size_t counts[258] = { 0 };
+    auto bucketOf = [&](int row) { return values[row].empty() ? 0 : (unsigned char)values[row][0] + 1; };
+    for (size_t i = 0; i < n; ++i) ++counts[bucketOf(order[i]) + 1];
+    for (int b = 0; b < 257; ++b) counts[b + 1] += counts[b];
+    size_t starts[258];
+    copy(counts, counts + 258, starts);
+    for (size_t i = 0; i < n; ++i) scratch[counts[bucketOf(order[i])]++] = order[i];
+    order.swap(scratch);
+
+    atomic<int> nextBucket(1);
+    parallelFor(threads, [&](int) {
+        for (int b = nextBucket++; b < 257; b = nextBucket++) {
+            size_t size = starts[b + 1] - starts[b];
+            if (size > 1) msdRadixSort(&order[starts[b]], &scratch[starts[b]], size, 1, values);
+        }
+    });
+    return order;
+}
+
+// Dictionary-encode text: codes[i] is the rank of values[i] among the distinct values
+inline vector<uint32_t> dictionaryEncode(const vector<string> &values, int threads) {
+    unordered_map<string, uint32_t> slot;
+    vector<string> distinct;
+    vector<uint32_t> codes(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        auto it = slot.emplace(values[i], (uint32_t)distinct.size());
+        if (it.second) distinct.push_back(values[i]);
+        codes[i] = it.first->second;
+    }
+    vector<int> order = sortStrings(distinct, threads);
+    vector<uint32_t> rank(distinct.size());
+    for (size_t r = 0; r < order.size(); ++r) rank[order[r]] = (uint32_t)r;
+    for (uint32_t &code : codes) code = rank[code];
+    return codes;
+}
+
+// Stable LSD radix sort of a permutation by fixed-width columns, columns[0] most significant
+inline vector<int> radixSortColumns(const vector<vector<uint32_t>> &columns, size_t n, int threads) {
+    vector<int> perm(n), next(n);
+    for (size_t i = 0; i < n; ++i) perm[i] = (int)i;
+    if (n < 2) return perm;
+    if ((size_t)threads > n / 4096 + 1) threads = (int)(n / 4096 + 1); // Not worth threads for tiny inputs
+
+    for (size_t c = columns.size(); c-- > 0;) {
+        const uint32_t *key = columns[c].data();
+        uint32_t allOr = 0, allAnd = 0xFFFFFFFFu;
+        for (size_t i = 0; i < n; ++i) { allOr |= key[i]; allAnd &= key[i]; }
+
+        for (int shift = 0; shift < 32; shift += 8) {
+            if ((((allOr ^ allAnd) >> shift) & 0xFF) == 0) continue; // Same byte everywhere
+
+            vector<vector<size_t>> offsets(threads, vector<size_t>(256, 0));
+            size_t chunk = (n + threads - 1) / threads;
+            parallelFor(threads, [&](int t) {
+                size_t from = t * chunk, to = min(n, from + chunk);
+                vector<size_t> &hist = offsets[t];
+                for (size_t i = from; i < to; ++i) ++hist[(key[perm[i]] >> shift) & 0xFF];
+            });
+            // Bucket-major, thread-minor prefix sums keep the pass stable
+            size_t running = 0;
+            for (int b = 0; b < 256; ++b) {
+                for (int t = 0; t < threads; ++t) {
+                    size_t count = offsets[t][b];
+                    offsets[t][b] = running;
+                    running += count;
+                }
+            }
+            parallelFor(threads, [&](int t) {
+                size_t from = t * chunk, to = min(n, from + chunk);
+                vector<size_t> &pos = offsets[t];
+                for (size_t i = from; i < to; ++i) next[pos[(key[perm[i]] >> shift) & 0xFF]++] = perm[i];
+            });
+            perm.swap(next);
+        }
+    }
+    return perm;
+}
+
+// Merge sorted run files of "key<TAB>line" rows into out, writing only the lines; rows counts
+// the lines written. False if a run can't be opened or read to its end, or out fails.
+inline bool mergeRuns(const vector<string> &runFiles, ostream &out, size_t &rows) {
+    rows = 0;
+    vector<ifstream> runs(runFiles.size());
+    typedef pair<string, size_t> Head; // (row, run)
+    priority_queue<Head, vector<Head>, greater<Head>> heads;
+    for (size_t r = 0; r < runFiles.size(); ++r) {
+        runs[r].open(runFiles[r]);
+        if (!runs[r]) return false;
+        string row;
+        if (getline(runs[r], row)) heads.push({ row, r });
+    }
+    while (!heads.empty() && out) {
+        Head head = heads.top();
+        heads.pop();
+        out << head.first.substr(head.first.find('\t') + 1) << '\n';
+        ++rows;
+        string row;
+        if (getline(runs[head.second], row)) heads.push({ row, head.second });
+    }
+    for (ifstream &run : runs) {
+        if (run.bad() || !run.eof()) return false;
+    }
+    return (bool)out;
+}
+
+// Check every routine above against std::sort on seeded random data, adding a PASS/FAIL line per
+// check to report. Run files are written as <scratchPrefix><n>.run and removed afterwards.
+inline bool selfTestSort(const string &scratchPrefix, string &report) {
+    mt19937 rng(20250601);
+    bool passed = true;
+    auto check = [&](const string &what, bool ok) {
+        report += (ok ? "PASS " : "FAIL ") + what + "\n";
+        if (!ok) passed = false;
+    };
+
+    // Columns with few distinct values, so ties are common and stability shows; the middle column
+    // has the same top byte everywhere and the last varies only in its top byte
+    for (size_t n : { (size_t)0, (size_t)1, (size_t)17, (size_t)5000, (size_t)300000 }) {
+        vector<vector<uint32_t>> columns(3, vector<uint32_t>(n));
+        for (size_t i = 0; i < n; ++i) {
+            columns[0][i] = rng() % 50;
+            columns[1][i] = 0x7F000000u | (rng() % 1000);
+            columns[2][i] = (rng() % 8) << 24;
+        }
+        vector<int> expected(n);
+        for (size_t i = 0; i < n; ++i) expected[i] = (int)i;
+        stable_sort(expected.begin(), expected.end(), [&](int a, int b) {
+            for (const auto &column : columns) {
+                if (column[a] != column[b]) return column[a] < column[b];
+            }
+            return false;
+        });
+        for (int threads : { 1, 4 }) {
+            check("radixSortColumns " + to_string(n) + " rows, " + to_string(threads) + " thread(s), stable",
+                  radixSortColumns(columns, n, threads) == expected);
+        }
+    }
+
+    // Strings over a small alphabet so prefixes are shared, with empty values and bytes above 0x7F
+    const char alphabet[] = { 'a', 'b', 'c', ' ', '\xC3', '\xFF' };
+    vector<string> values(20000);
+    for (string &value : values) {
+        size_t length = rng() % 12;
+        for (size_t k = 0; k < length; ++k) value += alphabet[rng() % 6];
+    }
+    vector<string> sortedValues = values;
+    sort(sortedValues.begin(), sortedValues.end());
+    for (int threads : { 1, 4 }) {
+        vector<int> order = sortStrings(values, threads);
+        vector<int> seen(order.begin(), order.end());
+        sort(seen.begin(), seen.end());
+        bool ok = order.size() == values.size();
+        for (size_t i = 0; ok && i < order.size(); ++i) ok = seen[i] == (int)i && values[order[i]] == sortedValues[i];
+        check("sortStrings 20000 values, " + to_string(threads) + " thread(s)", ok);
+
+        vector<uint32_t> codes = dictionaryEncode(values, threads);
+        vector<string> distinct = sortedValues;
+        distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+        ok = codes.size() == values.size();
+        for (size_t i = 0; ok && i < codes.size(); ++i) {
+            ok = codes[i] == (uint32_t)(lower_bound(distinct.begin(), distinct.end(), values[i]) - distinct.begin());
+        }
+        check("dictionaryEncode 20000 values, " + to_string(threads) + " thread(s)", ok);
+    }
+
+    // Rows dealt at random into runs (one left empty), each run sorted as an export would write it
+    vector<string> rows;
+    for (size_t i = 0; i < 30000; ++i) rows.push_back(values[i % values.size()] + "\t" + "line " + to_string(i));
+    vector<vector<string>> runRows(5);
+    for (const string &row : rows) runRows[rng() % 4].push_back(row);
+    vector<string> runFiles;
+    bool written = true;
+    for (size_t r = 0; r < runRows.size(); ++r) {
+        sort(runRows[r].begin(), runRows[r].end());
+        runFiles.push_back(scratchPrefix + to_string(r) + ".run");
+        ofstream out(runFiles.back());
+        for (const string &row : runRows[r]) out << row << '\n';
+        written = written && (bool)out;
+    }
+    sort(rows.begin(), rows.end());
+    string expected;
+    for (const string &row : rows) expected += row.substr(row.find('\t') + 1) + '\n';
+    ostringstream merged;
+    size_t mergedRows = 0;
+    bool merging = written && mergeRuns(runFiles, merged, mergedRows);
+    check("mergeRuns 30000 rows in 5 runs", merging && mergedRows == rows.size() && merged.str() == expected);
+    runFiles.push_back(scratchPrefix + "missing.run");
+    check("mergeRuns fails when a run file is missing", !mergeRuns(runFiles, merged, mergedRows));
+    for (const string &file : runFiles) remove(file.c_str());
+    return passed;
+}
@@ -0,0 +1,233 @@
+// Field validation shared by every version of the program
+// Names are ASCII letters and spaces, amounts are digits with at most one decimal point, and dates
+// are MM/DD/YYYY with a real month and day. The checks compare byte ranges directly, so they don't
+// depend on the C locale the way isalpha and isdigit do. On x86 they look at 16 bytes at a time
+// (SSE2), or 32 with AVX2 when the CPU has it, and the last partial block goes through a zero-padded
+// copy with a length mask, so short fields like "Ana Cruz" are one vector step too. Everywhere else
+// a scalar loop gives the same answers. validateBatch checks a whole column of NUL-terminated fields,
+// finding each field's end in the same vector pass instead of calling strlen first.
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VALIDATE_SIMD 1
+#include <immintrin.h>
+#endif
+
+enum FieldKind { FIELD_NAME, FIELD_AMOUNT, FIELD_DATE };
+
+// Scalar checks for single characters
+inline bool isAsciiLetter(char c) { return (unsigned char)((c | 0x20) - 'a') < 26; }
+inline bool isAsciiDigit(char c) { return (unsigned char)(c - '0') < 10; }
+
+// Scalar kernels: each returns how many leading bytes pass, and counts decimal points for amounts
+inline size_t nameRunScalar(const char *s, size_t n) {
+    size_t i = 0;
+    while (i < n && (isAsciiLetter(s[i]) || s[i] == ' ')) ++i;
+    return i;
+}
+inline size_t amountRunScalar(const char *s, size_t n, size_t &dots) {
+    size_t i = 0;
+    for (; i < n; ++i) {
+        if (s[i] == '.') ++dots;
+        else if (!isAsciiDigit(s[i])) break;
+    }
+    return i;
+}
+
+#ifdef VALIDATE_SIMD
+// Lanes holding an ASCII letter or a space: (c | 0x20) - 'a' < 26, done as a signed compare
+inline __m128i nameLanes128(__m128i c) {
+    __m128i shifted = _mm_add_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8((char)(128 - 'a')));
+    __m128i letter = _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(-128 + 26)));
+    return _mm_or_si128(letter, _mm_cmpeq_epi8(c, _mm_set1_epi8(' ')));
+}
+inline __m128i digitLanes128(__m128i c) {
+    __m128i shifted = _mm_add_epi8(c, _mm_set1_epi8((char)(128 - '0')));
+    return _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(-128 + 10)));
+}
+
+// The last n < 16 bytes of a field, zero-padded into one vector
+inline __m128i loadTail128(const char *s, size_t n) {
+    char padded[16] = { 0 };
+    memcpy(padded, s, n);
+    return _mm_loadu_si128((const __m128i *)padded);
+}
+
+// Leading lanes of ok that pass, given that only the low n lanes matter
+inline size_t passingLanes(unsigned ok, size_t n) {
+    unsigned failed = ~ok & (n >= 32 ? ~0u : (1u << n) - 1);
+    return failed ? (size_t)__builtin_ctz(failed) : n;
+}
+
+inline size_t nameRunSse2(const char *s, size_t n) {
+    for (size_t i = 0; i < n; i += 16) {
+        size_t lanes = n - i < 16 ? n - i : 16;
+        __m128i c = lanes == 16 ? _mm_loadu_si128((const __m128i *)(s + i)) : loadTail128(s + i, lanes);
+        size_t run = passingLanes((unsigned)_mm_movemask_epi8(nameLanes128(c)), lanes);
+        if (run < lanes) return i + run;
+    }
+    return n;
+}
+inline size_t amountRunSse2(const char *s, size_t n, size_t &dots) {
+    for (size_t i = 0; i < n; i += 16) {
+        size_t lanes = n - i < 16 ? n - i : 16;
+        __m128i c = lanes == 16 ? _mm_loadu_si128((const __m128i *)(s + i)) : loadTail128(s + i, lanes);
+        unsigned dot = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('.')));
+        size_t run = passingLanes((unsigned)_mm_movemask_epi8(digitLanes128(c)) | dot, lanes);
+        dots += __builtin_popcount(dot & ((1u << run) - 1));
+        if (run < lanes) return i + run;
+    }
+    return n;
+}
+
+// 16 bytes at p, or fewer zero-padded ones when a full load would cross into the next page.
+// Reading past a field's end inside the same page can't fault, and stops at its NUL anyway.
+__attribute__((no_sanitize_address)) inline __m128i loadField128(const char *p) {
+    if (((uintptr_t)p & 4095) <= 4096 - 16) return _mm_loadu_si128((const __m128i *)p);
+    char padded[16] = { 0 };
+    for (size_t i = 0; i < 16 && (i == 0 || p[i - 1] != '\0'); ++i) padded[i] = p[i];
+    return _mm_loadu_si128((const __m128i *)padded);
+}
+
+// Whole NUL-terminated fields, with the end found in the same pass as the check
+inline bool nameFieldSse2(const char *s) {
+    for (size_t i = 0;; i += 16) {
+        __m128i c = loadField128(s + i);
+        unsigned end = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_setzero_si128()));
+        unsigned ok = (unsigned)_mm_movemask_epi8(nameLanes128(c));
+        if (end) {
+            unsigned before = (end & -end) - 1; // Lanes ahead of the NUL
+            return (ok & before) == before && (i > 0 || before != 0);
+        }
+        if (ok != 0xFFFF) return false;
+    }
+}
+inline bool amountFieldSse2(const char *s) {
+    size_t dots = 0, length = 0;
+    for (size_t i = 0;; i += 16) {
+        __m128i c = loadField128(s + i);
+        unsigned end = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_setzero_si128()));
+        unsigned dot = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('.')));
+        unsigned ok = (unsigned)_mm_movemask_epi8(digitLanes128(c)) | dot;
+        unsigned lanes = end ? (end & -end) - 1 : 0xFFFF;
+        if ((ok & lanes) != lanes) return false;
+        dots += __builtin_popcount(dot & lanes);
+        length += __builtin_popcount(lanes);
+        if (end) return length > dots && dots <= 1;
+    }
+}
+
+// Full 32-byte blocks; the tail, under 32 bytes, takes at most two SSE2 steps
+__attribute__((target("avx2"))) inline size_t nameRunAvx2(const char *s, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i shifted = _mm256_add_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8((char)(128 - 'a')));
+        __m256i letter = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 26)), shifted);
+        __m256i ok = _mm256_or_si256(letter, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(ok);
+        if (mask != 0xFFFFFFFFu) return i + passingLanes(mask, 32);
+    }
+    return i + nameRunSse2(s + i, n - i);
+}
+__attribute__((target("avx2"))) inline size_t amountRunAvx2(const char *s, size_t n, size_t &dots) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i shifted = _mm256_add_epi8(c, _mm256_set1_epi8((char)(128 - '0')));
+        unsigned digit = (unsigned)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 10)), shifted));
+        unsigned dot = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('.')));
+        if ((digit | dot) != 0xFFFFFFFFu) {
+            size_t run = passingLanes(digit | dot, 32);
+            dots += __builtin_popcount(dot & ((1u << run) - 1));
+            return i + run;
+        }
+        dots += __builtin_popcount(dot);
+    }
+    return i + amountRunSse2(s + i, n - i, dots);
+}
+#endif
+
+typedef size_t (*NameKernel)(const char *, size_t);
+typedef size_t (*AmountKernel)(const char *, size_t, size_t &);
+
+// Widest kernels this CPU runs, picked on first use
+inline NameKernel nameKernel() {
+#ifdef VALIDATE_SIMD
+    static const NameKernel kernel = __builtin_cpu_supports("avx2") ? nameRunAvx2 : nameRunSse2;
+    return kernel;
+#else
+    return nameRunScalar;
+#endif
+}
+inline AmountKernel amountKernel() {
+#ifdef VALIDATE_SIMD
+    static const AmountKernel kernel = __builtin_cpu_supports("avx2") ? amountRunAvx2 : amountRunSse2;
+    return kernel;
+#else
+    return amountRunScalar;
+#endif
+}
+
+// Letters and spaces only, not empty
+inline bool validName(const char *s, size_t n) {
+    return n > 0 && nameKernel()(s, n) == n;
+}
+inline bool validName(const string &s) { return validName(s.data(), s.size()); }
+
+// Digits with at most one decimal point, and at least one digit ("12", "12.5", ".5")
+inline bool validAmount(const char *s, size_t n) {
+    size_t dots = 0;
+    return n > 0 && amountKernel()(s, n, dots) == n && dots <= 1 && n > dots;
+}
+inline bool validAmount(const string &s) { return validAmount(s.data(), s.size()); }
+
+// MM/DD/YYYY with month 01-12 and a day that exists in that month
+inline bool validDate(const char *s, size_t n) {
+    if (n != 10) return false;
+#ifdef VALIDATE_SIMD
+    // Check all ten positions at once: digits everywhere except the two slashes
+    char padded[16] = { 0 };
+    memcpy(padded, s, 10);
+    __m128i c = _mm_loadu_si128((const __m128i *)padded);
+    int digits = _mm_movemask_epi8(digitLanes128(c));
+    int slashes = _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('/')));
+    if ((digits & 0x3DB) != 0x3DB || (slashes & 0x24) != 0x24) return false;
+#else
+    for (size_t i = 0; i < 10; ++i) {
+        if (i == 2 || i == 5 ? s[i] != '/' : !isAsciiDigit(s[i])) return false;
+    }
+#endif
+    int month = (s[0] - '0') * 10 + (s[1] - '0');
+    int day = (s[3] - '0') * 10 + (s[4] - '0');
+    int year = (s[6] - '0') * 1000 + (s[7] - '0') * 100 + (s[8] - '0') * 10 + (s[9] - '0');
+    static const int monthDays[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1]) return false;
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return !(month == 2 && day == 29 && !leap);
+}
+inline bool validDate(const string &s) { return validDate(s.data(), s.size()); }
+
+// Validate NUL-terminated fields[i] for every i, writing 1 or 0 to ok[i]; returns how many were valid.
+// Fields are short, so one 16-byte step usually finds the end and checks the whole field; the kernel
+// is called directly in the loop rather than through a pointer.
+inline size_t validateBatch(FieldKind kind, const vector<const char *> &fields, vector<unsigned char> &ok) {
+    ok.resize(fields.size());
+    size_t valid = 0;
+    for (size_t i = 0; i < fields.size(); ++i) {
+#ifdef VALIDATE_SIMD
+        if (kind == FIELD_NAME) ok[i] = nameFieldSse2(fields[i]);
+        else if (kind == FIELD_AMOUNT) ok[i] = amountFieldSse2(fields[i]);
+#else
+        if (kind == FIELD_NAME) ok[i] = validName(fields[i], strlen(fields[i]));
+        else if (kind == FIELD_AMOUNT) ok[i] = validAmount(fields[i], strlen(fields[i]));
+#endif
+        else ok[i] = validDate(fields[i], strnlen(fields[i], 11));
+        valid += ok[i];
+    }
+    return valid;
+}
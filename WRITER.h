@@ -0,0 +1,212 @@
+// Background writer: persists record mutations on its own thread so the menu never waits on disk
+// Producers push mutations onto a lock-free MPSC queue. The writer thread applies them to its own
+// copy of the records and rewrites the file once per burst, however many mutations the burst held.
+// A failed save is retried every second, and right away on flush, until it goes through; stop
+// retries a few more times and reports whether everything reached the disk.
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <map>
+#include <string>
+
+template <typename Record>
+class BackgroundWriter {
+public:
+    // Writes every record to disk; returns false and fills error on failure
+    typedef function<bool(const map<int, Record> &, string &)> SaveFunction;
+    // Sees each mutation as it is applied: before is null for a new record, after is null for a delete
+    typedef function<void(int, const Record *, const Record *)> ApplyFunction;
+
+private:
+    // What a queued mutation does to the writer's copy
+    enum Kind { ADD, REMOVE, EVICT };
+
+    // One queued mutation
+    struct Node {
+        atomic<Node *> next;
+        Kind kind;
+        int id;
+        Record record; // New record for ADD, removed record for REMOVE
+    };
+
+    atomic<Node *> head;  // Most recently pushed node (producers)
+    Node *tail;           // Oldest node, already consumed (writer thread only)
+
+    map<int, Record> shadow;        // Writer thread's copy of the records
+    SaveFunction save;
+    ApplyFunction onApply;
+    thread worker;
+    atomic<bool> stopping;
+    atomic<unsigned long long> submitted; // Mutations pushed so far
+    atomic<unsigned long long> durable;   // Mutations written so far
+    atomic<unsigned long long> attempted; // Mutations covered by the latest save, successful or not
+    atomic<unsigned long long> attempts;  // Saves finished so far
+    atomic<bool> retryNow;                // A flush wants a failed save retried without waiting
+    mutex waitMutex;                      // Only used to sleep and wake, never around the queue
+    condition_variable wake, done;
+    mutex errorMutex;
+    string lastError;
+
+    // Pop the oldest mutation; returns false if the queue is empty
+    bool pop(Node *&out) {
+        Node *next = tail->next.load(memory_order_acquire);
+        if (!next) return false;
+        delete tail;
+        tail = next; // The popped node becomes the new stub
+        out = next;
+        return true;
+    }
+
+    // Writer thread: wait for work, drain a burst, write once
+    void loop() {
+        const chrono::milliseconds burstWindow(20); // Let a burst settle before writing
+        const chrono::milliseconds retryDelay(1000); // Between attempts while the file is behind
+        unsigned long long applied = 0;
+        bool unsaved = false; // The last save failed, so the file is behind the copy
+        int finalRetries = 3; // Attempts left once stopping with an unsaved copy
+        while (true) {
+            {
+                unique_lock<mutex> lk(waitMutex);
+                // The timeout covers a notify that lands before we start waiting, and paces retries
+                wake.wait_for(lk, unsaved ? retryDelay : chrono::milliseconds(200), [&] {
+                    return stopping.load() || submitted.load() > applied || retryNow.load();
+                });
+            }
+            retryNow.store(false);
+            bool pending = submitted.load() > applied;
+            if (!pending && !unsaved) {
+                if (stopping.load()) break;
+                continue;
+            }
+            if (!pending && stopping.load()) {
+                if (finalRetries-- == 0) break;
+                this_thread::sleep_for(chrono::milliseconds(100));
+            }
+            if (pending && !stopping.load()) this_thread::sleep_for(burstWindow);
+
+            Node *node;
+            while (pop(node)) {
+                if (node->kind == EVICT) {
+                    // Moved to another tier; not a change anyone downstream needs to see
+                    shadow.erase(node->id);
+                } else if (node->kind == REMOVE) {
+                    if (onApply) onApply(node->id, &node->record, nullptr);
+                    shadow.erase(node->id);
+                } else {
+                    auto existing = shadow.find(node->id);
+                    if (onApply) onApply(node->id, existing == shadow.end() ? nullptr : &existing->second, &node->record);
+                    shadow[node->id] = node->record;
+                }
+                ++applied;
+            }
+
+            string error;
+            unsaved = !save(shadow, error);
+            if (unsaved) {
+                lock_guard<mutex> lk(errorMutex);
+                lastError = error;
+            }
+            {
+                lock_guard<mutex> lk(waitMutex);
+                if (!unsaved) durable.store(applied);
+                attempted.store(applied);
+                attempts.fetch_add(1);
+            }
+            done.notify_all();
+        }
+    }
+
+    // Push a mutation and wake the writer
+    void push(Node *node) {
+        node->next.store(nullptr, memory_order_relaxed);
+        Node *prev = head.exchange(node, memory_order_acq_rel);
+        prev->next.store(node, memory_order_release);
+        submitted.fetch_add(1);
+        wake.notify_one();
+    }
+
+public:
+    BackgroundWriter() : stopping(false), submitted(0), durable(0), attempted(0), attempts(0), retryNow(false) {
+        Node *stub = new Node();
+        stub->next.store(nullptr);
+        head.store(stub);
+        tail = stub;
+    }
+
+    ~BackgroundWriter() {
+        stop();
+        while (Node *next = tail->next.load()) {
+            delete tail;
+            tail = next;
+        }
+        delete tail;
+    }
+
+    // Start the writer thread with the records already on disk
+    void start(const map<int, Record> &initial, SaveFunction saveFunction, ApplyFunction applyFunction = nullptr) {
+        shadow = initial;
+        save = saveFunction;
+        onApply = applyFunction;
+        worker = thread(&BackgroundWriter::loop, this);
+    }
+
+    // Flush everything and stop the writer thread; false if some changes never reached the file
+    bool stop() {
+        if (!worker.joinable()) return durable.load() == submitted.load();
+        stopping.store(true);
+        wake.notify_one();
+        worker.join();
+        return durable.load() == submitted.load();
+    }
+
+    // Queue a record to be added or replaced
+    void submitAdd(int id, const Record &record) {
+        Node *node = new Node();
+        node->kind = ADD;
+        node->id = id;
+        node->record = record;
+        push(node);
+    }
+
+    // Queue a record to be removed; the removed record is passed on to the apply hook
+    void submitRemove(int id, const Record &removed) {
+        Node *node = new Node();
+        node->kind = REMOVE;
+        node->id = id;
+        node->record = removed;
+        push(node);
+    }
+
+    // Queue a record to be dropped from the saved file because another tier now holds it
+    void submitEvict(int id) {
+        Node *node = new Node();
+        node->kind = EVICT;
+        node->id = id;
+        push(node);
+    }
+
+    // Block until every mutation submitted so far has been written, or a save attempted after
+    // the call has failed; returns whether they were written
+    bool flush() {
+        if (!worker.joinable()) return durable.load() >= submitted.load();
+        unsigned long long target = submitted.load();
+        unsigned long long since = attempts.load();
+        retryNow.store(true);
+        wake.notify_one();
+        unique_lock<mutex> lk(waitMutex);
+        done.wait(lk, [&] { return durable.load() >= target || (attempts.load() > since && attempted.load() >= target); });
+        return durable.load() >= target;
+    }
+
+    // Return and clear the most recent write error, or "" if none
+    string takeError() {
+        lock_guard<mutex> lk(errorMutex);
+        string error = lastError;
+        lastError.clear();
+        return error;
+    }
+};